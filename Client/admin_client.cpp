@@ -12,7 +12,7 @@ Admin_Client::Admin_Client(QWidget *parent)
 
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &Admin_Client::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveAdminChart, this, &Admin_Client::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &Admin_Client::onErrorOccurred);
 
     // 延迟100毫秒后执行
@@ -35,13 +35,6 @@ void Admin_Client::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveAdminChart) {
-        qDebug() << "Admin_Client::onDataReceived:当前不是Chart接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"Admin_Client::onDataReceived:状态设置为Idle";
@@ -7,20 +7,67 @@ Doctor_Client::Doctor_Client(QWidget *parent)
 {
     ui->setupUi(this);
 
+    // 预约列表：最后一列只给下拉框用，表格里不显示
+    appointmentModel = new RecordModel({
+        { "患者用户名", "patientUsername", nullptr },
+        { "日期", "date", nullptr },
+        { "就诊时间", "time", nullptr },
+        { "费用", "cost", nullptr },
+        { "状态", "status", nullptr },
+        { "预约", QString(), [](const QJsonObject &a) {
+              return "患者用户名：" + a["patientUsername"].toString() + "    日期：" + a["date"].toString()
+                     + "    就诊时间：" + a["time"].toString();
+          } },
+    }, [](const QJsonObject &a) {
+        return a["patientUsername"].toString() + '/' + a["doctorUsername"].toString() + '/'
+               + a["date"].toString() + '/' + a["time"].toString();
+    }, this);
+    ui->docAppointmentTableView->setModel(appointmentModel);
+    RecordModel::setupView(ui->docAppointmentTableView);
+    ui->docAppointmentTableView->setColumnHidden(5, true);
+
+    waitingModel = new QSortFilterProxyModel(this);
+    waitingModel->setSourceModel(appointmentModel);
+    waitingModel->setFilterKeyColumn(4);
+    waitingModel->setFilterRegularExpression(QRegularExpression("^waiting$"));
+    ui->comboBox->setModel(waitingModel);
+    ui->comboBox->setModelColumn(5);
+
     StateManager::instance().setState(WidgetState::waitReciveDoctorAppointmentList);
     qDebug()<<"Doctor_Client:构造函数:状态设置为waitReciveDoctorAppointmentList";
 
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &Doctor_Client::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorAppointmentList, this, &Doctor_Client::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &Doctor_Client::onErrorOccurred);
 
+    // 通知窗口随登录创建一次，隐藏期间也接收推送；关闭只是隐藏，不重复订阅
+    // 以本窗口为父对象随之销毁，Qt::Window 使它仍是独立的顶层窗口
+    doctornoticeclient = new doctorNoticeClient(this);
+    doctornoticeclient->setWindowFlag(Qt::Window);
+    doctornoticeclient->setAttribute(Qt::WA_DeleteOnClose, false);
+
     // 延迟100毫秒后执行
     // QTimer::singleShot(100, this, [this]() {
     //     // 这里写延迟后要执行的代码
     //     qDebug() << "延迟100ms后执行";
     // });
 
+    // 先订阅预约变更再查列表，查询期间发生的变更也不会漏；之后列表只按推送逐行更新，不再重新查询
+    ReplyDispatcher::instance().routePush("change", this, [this](const QJsonObject &change) {
+        if (change["entity"].toString() == "appointment") {
+            appointmentModel->merge(change["row"].toObject());
+        }
+    });
+    QJsonObject subscription;
+    subscription["entity"] = "appointment";
+    subscription["username"] = UserSession::instance().getValue("username");
+    tcpClient->request("subscribe", subscription, [](const QJsonObject &reply) {
+        if (reply["reply"].toString() != "successful") {
+            qDebug() << "Doctor_Client::订阅预约变更失败:" << reply["reply"].toString();
+        }
+    }, this);
+
     JsonMessageBuilder *builder=new JsonMessageBuilder("queryAppointmentList");
     tcpClient->sendData(builder->build());
     delete builder; // 记得释放内存
@@ -28,34 +75,17 @@ Doctor_Client::Doctor_Client(QWidget *parent)
 
 Doctor_Client::~Doctor_Client()
 {
+    QJsonObject subscription;
+    subscription["entity"] = "appointment";
+    tcpClient->request("unsubscribe", subscription, [](const QJsonObject &) {});
     delete ui;
 }
 
 void Doctor_Client::onDataReceived(const QJsonObject &data){
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果当前不是医生预约列表状态，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorAppointmentList) {
-        qDebug() << "Doctor_Client::onDataReceived:当前不是医生预约列表接收状态，忽略接收到的数据";
-        return;
-    }
-
     qDebug()<<"Doctor_Client::onDataReceived:正在接受预约列表";
 
-    appointments=DataManager::instance().extractAppointments(data);
-
-    for (const DataManager::AppointmentInfo &appointment : appointments) {
-        const QString each_instance=QString("患者用户名：")+QString(appointment.patientUsername)
-                                      +QString("    日期：")+QString(appointment.date)+QString("    就诊时间：")
-                                      +QString(appointment.time)+QString("  费用：")+QString(appointment.cost)
-                                      +QString("    状态：")+QString(appointment.status);
-        ui->docAppointmentListWidget->addItem(each_instance);
-        if(appointment.status=="waiting"){
-            ui->comboBox->addItem(QString("患者用户名：")+QString(appointment.patientUsername)
-                                  +QString("    日期：")+QString(appointment.date)+QString("    就诊时间："));
-        }
-    }
+    // 只有新增、删除和状态有变的行会重绘，待确认的下拉框跟着更新
+    appointmentModel->sync(RecordModel::recordsIn(data, "appointment_"));
 
 
 }  // 添加数据接收槽
@@ -185,40 +215,29 @@ void Doctor_Client::on_pushButton_2_clicked()
 {
 
 
-    doctornoticeclient = new doctorNoticeClient/*(this)*/;
-        //设置窗口属性
-
+    // 通知窗口登录时已创建并订阅通知，这里只负责显示
     doctornoticeclient->show();
 }
 
 
 void Doctor_Client::on_pushButton_clicked()
 {
-    for (const DataManager::AppointmentInfo &appointment : appointments) {
-        const QString each_instance=QString("患者用户名：")+QString(appointment.patientUsername)
-                                      +QString("    日期：")+QString(appointment.date)+QString("    就诊时间：")
-                                      +QString(appointment.time)+QString("  费用：")+QString(appointment.cost)
-                                      +QString("    状态：")+QString(appointment.status);
-        ui->docAppointmentListWidget->addItem(each_instance);
-        if(ui->comboBox->currentText()==QString("患者用户名：")+QString(appointment.patientUsername)
-                                               +QString("    日期：")+QString(appointment.date)+QString("    就诊时间：")){
-            JsonMessageBuilder *builder=new JsonMessageBuilder("modifyAppointment");
-            builder->addAppointment(appointment.patientUsername,UserSession::instance().getValue("username"),
-                                    QString(appointment.date),QString(appointment.time),QString(appointment.cost),"accept");
-            tcpClient->sendData(builder->build());
-            delete builder;
-
-            ui->docAppointmentListWidget->clear();
-
-            StateManager::instance().setState(WidgetState::waitReciveDoctorAppointmentList);
-            qDebug()<<"Doctor_Client:构造函数:状态设置为waitReciveDoctorAppointmentList";
-
-            builder=new JsonMessageBuilder("queryAppointmentList");
-            tcpClient->sendData(builder->build());
-            delete builder; // 记得释放内存
-
-            return;
-        }
+    // 下拉框的行直接对应预约记录，不必再拼字符串去比对
+    const int row = ui->comboBox->currentIndex();
+    if (row < 0) {
+        return;
     }
+    const QJsonObject appointment = appointmentModel->recordAt(waitingModel->mapToSource(waitingModel->index(row, 0)).row());
+
+    // 确认后的新状态由变更推送更新到列表；回复单独处理，不能按列表状态分发，否则会被当成一份空列表
+    JsonMessageBuilder *builder=new JsonMessageBuilder("modifyAppointment");
+    builder->addAppointment(appointment["patientUsername"].toString(),UserSession::instance().getValue("username"),
+                            appointment["date"].toString(),appointment["time"].toString(),appointment["cost"].toString(),"accept");
+    tcpClient->request("modifyAppointment", builder->build()["data"].toObject(), [this](const QJsonObject &reply) {
+        if (reply["reply"].toString() != "successful") {
+            QMessageBox::warning(this, "确认预约失败", "确认预约失败：" + reply["reply"].toString());
+        }
+    }, this);
+    delete builder;
 }
 
@@ -7,6 +7,8 @@
 #include"../Notice/doctornoticeclient.h"
 
 #include"../Standard.h"
+#include <QSortFilterProxyModel>
+#include <QRegularExpression>
 namespace Ui {
 class Doctor_Client;
 }
@@ -44,7 +46,8 @@ private:
     doctorCaseClient *doctorcaseclient=nullptr;
     doctorAdviceMenuClient *doctoradvicemenuClient=nullptr;
     doctorNoticeClient *doctornoticeclient=nullptr;
-    QList<DataManager::AppointmentInfo> appointments;
+    RecordModel *appointmentModel;        // 预约列表，按患者、医生、日期、时间区分
+    QSortFilterProxyModel *waitingModel;  // 其中待确认的预约，供下拉框选择
 };
 
 #endif // DOCTOR_CLIENT_H
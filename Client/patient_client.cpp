@@ -8,21 +8,55 @@ Patient_Client::Patient_Client(QWidget *parent)
 {
     ui->setupUi(this);
 
+    // 预约列表：键和医生端相同，变更推送按键落到对应的行上
+    appointmentModel = new RecordModel({
+        { "医生用户名", "doctorUsername", nullptr },
+        { "日期", "date", nullptr },
+        { "就诊时间", "time", nullptr },
+        { "费用", "cost", nullptr },
+        { "状态", "status", nullptr },
+    }, [](const QJsonObject &a) {
+        return a["patientUsername"].toString() + '/' + a["doctorUsername"].toString() + '/'
+               + a["date"].toString() + '/' + a["time"].toString();
+    }, this);
+    ui->appointmentTableView->setModel(appointmentModel);
+    RecordModel::setupView(ui->appointmentTableView);
 
     StateManager::instance().setState(WidgetState::waitRecivePatientAppointmentList);
     qDebug()<<"Patient_Client::构造函数:状态设置为waitRecivePatientAppointmentList";
 
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &Patient_Client::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientAppointmentList, this, &Patient_Client::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &Patient_Client::onErrorOccurred);
 
+    // 通知窗口随登录创建一次，隐藏期间也接收推送；关闭只是隐藏，不重复订阅
+    // 以本窗口为父对象随之销毁，Qt::Window 使它仍是独立的顶层窗口
+    patientnoticeclient = new patientNoticeClient(this);
+    patientnoticeclient->setWindowFlag(Qt::Window);
+    patientnoticeclient->setAttribute(Qt::WA_DeleteOnClose, false);
+
     // 延迟100毫秒后执行
     // QTimer::singleShot(100, this, [this]() {
     //     // 这里写延迟后要执行的代码
     //     qDebug() << "延迟100ms后执行";
     // });
 
+    // 先订阅预约变更再查列表；之后预约、取消、医生确认都由推送逐行更新，不再重新查询
+    ReplyDispatcher::instance().routePush("change", this, [this](const QJsonObject &change) {
+        if (change["entity"].toString() == "appointment") {
+            appointmentModel->merge(change["row"].toObject());
+        }
+    });
+    QJsonObject subscription;
+    subscription["entity"] = "appointment";
+    subscription["username"] = UserSession::instance().getValue("username");
+    tcpClient->request("subscribe", subscription, [](const QJsonObject &reply) {
+        if (reply["reply"].toString() != "successful") {
+            qDebug() << "Patient_Client::订阅预约变更失败:" << reply["reply"].toString();
+        }
+    }, this);
+
         JsonMessageBuilder *builder=new JsonMessageBuilder("queryAppointmentList");
         tcpClient->sendData(builder->build());
         delete builder; // 记得释放内存
@@ -31,6 +65,9 @@ Patient_Client::Patient_Client(QWidget *parent)
 
 Patient_Client::~Patient_Client()
 {
+    QJsonObject subscription;
+    subscription["entity"] = "appointment";
+    tcpClient->request("unsubscribe", subscription, [](const QJsonObject &) {});
     delete ui;
 }
 
@@ -38,13 +75,6 @@ void Patient_Client::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitRecivePatientAppointmentList) {
-        qDebug() << "Patient_Client::onDataReceived:当前不是病人预约列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"Patient_Client::onDataReceived:状态设置为Idle";
@@ -52,15 +82,8 @@ void Patient_Client::onDataReceived(const QJsonObject &data){
 
     qDebug()<<"Patient_Client::onDataReceived:正在接受预约列表";
 
-    QList<DataManager::AppointmentInfo> appointments=DataManager::instance().extractAppointments(data);
-
-    for (const DataManager::AppointmentInfo &appointment : appointments) {
-        const QString each_instance=QString("医生用户名：")+QString(appointment.doctorUsername)
-                                      +QString("    日期：")+QString(appointment.date)+QString("    就诊时间：")
-                                      +QString(appointment.time)+QString("  费用：")+QString(appointment.cost)
-                                      +QString("    状态：")+QString(appointment.status);
-        ui->appointmentListWidget->addItem(each_instance);
-    }
+    // 按预约合并，不再每次把整份列表追加一遍
+    appointmentModel->sync(RecordModel::recordsIn(data, "appointment_"));
 
 
 }  // 添加数据接收槽
@@ -190,10 +213,7 @@ void Patient_Client::on_pushButton_clicked()
 
 void Patient_Client::on_pushButton_2_clicked()
 {
-    //这里一定要写，如果窗口关闭又打开，就会创建多个实例，导致ui信息无法显示
-    //如果实例不存在，则创建
-    patientnoticeclient = new patientNoticeClient/*(this)*/;
-
+    // 通知窗口登录时已创建并订阅通知，这里只负责显示
     patientnoticeclient->show();
 }
 
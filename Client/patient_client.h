@@ -51,6 +51,7 @@ private:
     patientAdviceClient *patientadviceclient=nullptr;
     patientHealthQuestionClient *patienthealthquestionclient=nullptr;
     patientNoticeClient *patientnoticeclient=nullptr;
+    RecordModel *appointmentModel;  // 我的预约，按患者、医生、日期、时间区分
 };
 
 #endif // PATIENT_CLIENT_H
@@ -1,7 +1,11 @@
 #include "DataManager.h"
+#include <QJsonArray>
 #include <QJsonValue>
 #include <QJsonObject>
+#include <QVector>
 #include <QDebug>
+#include <algorithm>
+#include <limits>
 
 DataManager& DataManager::instance()
 {
@@ -11,158 +15,224 @@ DataManager& DataManager::instance()
 
 DataManager::DataManager() {}
 
-// 提取预约信息
-QList<DataManager::AppointmentInfo> DataManager::extractAppointments(const QJsonObject &jsonData)
+namespace {
+
+// 结构体的一个字段：JSON 中的字段名和对应的成员
+template<typename T>
+struct Field
+{
+    const char *name;
+    QString T::*member;
+};
+
+// 每种记录一张字段表；表按字段名排好序，和 QJsonObject 的键顺序一致，解码时顺着往下对
+template<typename T, int N>
+struct Layout
+{
+    const char *prefix;  // 回复里的记录键为 prefix + "_" + 序号
+    const char *array;   // 也接受以数组形式给出的记录
+    QString T::*key;     // 保存记录键的成员，不需要时为空
+    Field<T> fields[N];
+};
+
+// 记录键中 prefix_ 之后的序号；不是数字时排在最后
+qint64 recordIndex(const QString &key, int from)
+{
+    if (from >= key.size()) {
+        return std::numeric_limits<qint64>::max();
+    }
+    qint64 n = 0;
+    for (int i = from; i < key.size(); ++i) {
+        const QChar c = key[i];
+        if (c < QLatin1Char('0') || c > QLatin1Char('9') || n > std::numeric_limits<qint64>::max() / 10 - 9) {
+            return std::numeric_limits<qint64>::max();
+        }
+        n = n * 10 + (c.unicode() - '0');
+    }
+    return n;
+}
+
+// 一条记录：按键顺序走一遍，每个键和字段表的下一项比较，对上了就取值，
+// 不再对每个字段各查一次；键顺序不合预期时绕回表头继续找，结果仍然正确
+template<typename T, int N>
+T decodeRecord(const QJsonObject &object, const Layout<T, N> &layout)
 {
-    QList<AppointmentInfo> appointments;
-    for (auto it = jsonData.constBegin(); it != jsonData.constEnd(); ++it) {
-        QString key = it.key();
-        if (key.startsWith("appointment_")) {
-            QJsonValue value = it.value();
-            if (value.isObject()) {
-                QJsonObject appointmentObj = value.toObject();
-                AppointmentInfo info;
-                info.appointmentKey = key;
-                info.patientUsername = appointmentObj["patientUsername"].toString();
-                info.doctorUsername = appointmentObj["doctorUsername"].toString();
-                info.date = appointmentObj["date"].toString();
-                info.time = appointmentObj["time"].toString();
-                info.cost = appointmentObj["cost"].toString();
-                info.status = appointmentObj["status"].toString();
-                appointments.append(info);
-                qDebug() << "提取预约:" << key
-                         << "患者:" << info.patientUsername
-                         << "医生:" << info.doctorUsername;
+    T info;
+    int next = 0;
+    for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+        const QString key = it.key();
+        for (int tried = 0; tried < N; ++tried) {
+            const Field<T> &field = layout.fields[(next + tried) % N];
+            if (key == QLatin1String(field.name)) {
+                info.*field.member = it.value().toString();
+                next = (next + tried + 1) % N;
+                break;
             }
         }
     }
-    return appointments;
+    return info;
 }
 
-// 提取患者信息
-QList<DataManager::PatientInfo> DataManager::extractPatients(const QJsonObject &jsonData)
+// 从回复中取出某种记录：只遍历一遍回复的键，按序号排序（appointment_2 在 appointment_10 之前），
+// 列表一次分配好
+template<typename T, int N>
+QList<T> decodeRecords(const QJsonObject &reply, const Layout<T, N> &layout)
 {
-    QList<PatientInfo> patients;
-    for (auto it = jsonData.constBegin(); it != jsonData.constEnd(); ++it) {
-        if (it.key().startsWith("patient_")) {
-            QJsonObject patientObj = it.value().toObject();
-            PatientInfo info;
-            info.username = patientObj["username"].toString();
-            info.name = patientObj["name"].toString();
-            info.gender = patientObj["gender"].toString();
-            info.birthday = patientObj["birthday"].toString();
-            info.id = patientObj["id"].toString();
-            info.phoneNumber = patientObj["phoneNumber"].toString();
-            info.email = patientObj["email"].toString();
-            patients.append(info);
+    const QLatin1String prefix(layout.prefix);
+    const int from = prefix.size() + 1;
+
+    struct Found
+    {
+        qint64 index;
+        QString key;
+        QJsonObject object;
+    };
+    QVector<Found> found;
+    const QJsonArray array = reply.value(QLatin1String(layout.array)).toArray();
+    found.reserve(array.size());
+    for (auto it = reply.constBegin(); it != reply.constEnd(); ++it) {
+        const QString key = it.key();
+        if (key.size() > prefix.size() && key.startsWith(prefix) && key[prefix.size()] == QLatin1Char('_')
+            && it.value().isObject()) {
+            found.append(Found{ recordIndex(key, from), key, it.value().toObject() });
+        }
+    }
+    std::stable_sort(found.begin(), found.end(), [](const Found &a, const Found &b) { return a.index < b.index; });
+
+    QList<T> records;
+    records.reserve(found.size() + array.size());
+    for (const Found &f : found) {
+        records.append(decodeRecord(f.object, layout));
+        if (layout.key) {
+            records.last().*layout.key = f.key;
         }
     }
-    return patients;
+    for (const QJsonValue &value : array) {
+        if (value.isObject()) {
+            records.append(decodeRecord(value.toObject(), layout));
+        }
+    }
+    return records;
+}
+
+using Appointment = DataManager::AppointmentInfo;
+const Layout<Appointment, 6> appointmentLayout{ "appointment", "appointments", &Appointment::appointmentKey, {
+    { "cost", &Appointment::cost },
+    { "date", &Appointment::date },
+    { "doctorUsername", &Appointment::doctorUsername },
+    { "patientUsername", &Appointment::patientUsername },
+    { "status", &Appointment::status },
+    { "time", &Appointment::time },
+} };
+
+using Patient = DataManager::PatientInfo;
+const Layout<Patient, 7> patientLayout{ "patient", "patients", nullptr, {
+    { "birthday", &Patient::birthday },
+    { "email", &Patient::email },
+    { "gender", &Patient::gender },
+    { "id", &Patient::id },
+    { "name", &Patient::name },
+    { "phoneNumber", &Patient::phoneNumber },
+    { "username", &Patient::username },
+} };
+
+using Doctor = DataManager::DoctorInfo;
+const Layout<Doctor, 8> doctorLayout{ "doctor", "doctors", nullptr, {
+    { "begin", &Doctor::begin },
+    { "cost", &Doctor::cost },
+    { "department", &Doctor::department },
+    { "end", &Doctor::end },
+    { "id", &Doctor::id },
+    { "limit", &Doctor::limit },
+    { "name", &Doctor::name },
+    { "username", &Doctor::username },
+} };
+
+using Case = DataManager::CaseInfo;
+const Layout<Case, 9> caseLayout{ "case", "cases", nullptr, {
+    { "check", &Case::check },
+    { "date", &Case::date },
+    { "diagnose", &Case::diagnose },
+    { "doctorUsername", &Case::doctorUsername },
+    { "main", &Case::main },
+    { "now", &Case::now },
+    { "past", &Case::past },
+    { "patientUsername", &Case::patientUsername },
+    { "time", &Case::time },
+} };
+
+using Advice = DataManager::AdviceInfo;
+const Layout<Advice, 8> adviceLayout{ "advice", "advices", nullptr, {
+    { "care", &Advice::care },
+    { "check", &Advice::check },
+    { "date", &Advice::date },
+    { "doctorUsername", &Advice::doctorUsername },
+    { "medicine", &Advice::medicine },
+    { "patientUsername", &Advice::patientUsername },
+    { "therapy", &Advice::therapy },
+    { "time", &Advice::time },
+} };
+
+using Notice = DataManager::NoticeInfo;
+const Layout<Notice, 4> noticeLayout{ "notice", "notices", nullptr, {
+    { "message", &Notice::message },
+    { "time", &Notice::time },
+    { "type", &Notice::type },
+    { "username", &Notice::username },
+} };
+
+using Question = DataManager::QuestionInfo;
+const Layout<Question, 8> questionLayout{ "question", "questions", nullptr, {
+    { "age", &Question::age },
+    { "gender", &Question::gender },
+    { "heart", &Question::heart },
+    { "height", &Question::height },
+    { "lung", &Question::lung },
+    { "name", &Question::name },
+    { "pressure", &Question::pressure },
+    { "weight", &Question::weight },
+} };
+
+}
+
+// 提取预约信息
+QList<DataManager::AppointmentInfo> DataManager::extractAppointments(const QJsonObject &jsonData)
+{
+    return decodeRecords(jsonData, appointmentLayout);
+}
+
+// 提取患者信息
+QList<DataManager::PatientInfo> DataManager::extractPatients(const QJsonObject &jsonData)
+{
+    return decodeRecords(jsonData, patientLayout);
 }
 
 // 提取医生信息
 QList<DataManager::DoctorInfo> DataManager::extractDoctors(const QJsonObject &jsonData)
 {
-    QList<DoctorInfo> doctors;
-    for (auto it = jsonData.constBegin(); it != jsonData.constEnd(); ++it) {
-        if (it.key().startsWith("doctor_")) {
-            QJsonObject doctorObj = it.value().toObject();
-            DoctorInfo info;
-            info.username = doctorObj["username"].toString();
-            info.name = doctorObj["name"].toString();
-            info.id = doctorObj["id"].toString();
-            info.department = doctorObj["department"].toString();
-            info.cost = doctorObj["cost"].toString();
-            info.begin = doctorObj["begin"].toString();
-            info.end = doctorObj["end"].toString();
-            info.limit = doctorObj["limit"].toString();
-            doctors.append(info);
-        }
-    }
-    return doctors;
+    return decodeRecords(jsonData, doctorLayout);
 }
 
 // 提取病例信息
 QList<DataManager::CaseInfo> DataManager::extractCases(const QJsonObject &jsonData)
 {
-    QList<CaseInfo> cases;
-    for (auto it = jsonData.constBegin(); it != jsonData.constEnd(); ++it) {
-        if (it.key().startsWith("case_")) {
-            QJsonObject caseObj = it.value().toObject();
-            CaseInfo info;
-            info.patientUsername = caseObj["patientUsername"].toString();
-            info.doctorUsername = caseObj["doctorUsername"].toString();
-            info.date = caseObj["date"].toString();
-            info.time = caseObj["time"].toString();
-            info.main = caseObj["main"].toString();
-            info.now = caseObj["now"].toString();
-            info.past = caseObj["past"].toString();
-            info.check = caseObj["check"].toString();
-            info.diagnose = caseObj["diagnose"].toString();
-            cases.append(info);
-        }
-    }
-    return cases;
+    return decodeRecords(jsonData, caseLayout);
 }
 
 // 提取医嘱信息
 QList<DataManager::AdviceInfo> DataManager::extractAdvices(const QJsonObject &jsonData)
 {
-    QList<AdviceInfo> advices;
-    for (auto it = jsonData.constBegin(); it != jsonData.constEnd(); ++it) {
-        if (it.key().startsWith("advice_")) {
-            QJsonObject adviceObj = it.value().toObject();
-            AdviceInfo info;
-            info.patientUsername = adviceObj["patientUsername"].toString();
-            info.doctorUsername = adviceObj["doctorUsername"].toString();
-            info.date = adviceObj["date"].toString();
-            info.time = adviceObj["time"].toString();
-            info.medicine = adviceObj["medicine"].toString();
-            info.check = adviceObj["check"].toString();
-            info.therapy = adviceObj["therapy"].toString();
-            info.care = adviceObj["care"].toString();
-            advices.append(info);
-        }
-    }
-    return advices;
+    return decodeRecords(jsonData, adviceLayout);
 }
 
 // 提取通知信息
 QList<DataManager::NoticeInfo> DataManager::extractNotices(const QJsonObject &jsonData)
 {
-    QList<NoticeInfo> notices;
-    for (auto it = jsonData.constBegin(); it != jsonData.constEnd(); ++it) {
-        if (it.key().startsWith("notice_")) {
-            QJsonObject noticeObj = it.value().toObject();
-            NoticeInfo info;
-            info.username = noticeObj["username"].toString();
-            info.type = noticeObj["type"].toString();
-            info.message = noticeObj["message"].toString();
-            info.time = noticeObj["time"].toString();
-            notices.append(info);
-        }
-    }
-    return notices;
+    return decodeRecords(jsonData, noticeLayout);
 }
 
 // 提取健康评估问卷
 QList<DataManager::QuestionInfo> DataManager::extractQuestions(const QJsonObject &jsonData)
 {
-    QList<QuestionInfo> questions;
-    for (auto it = jsonData.constBegin(); it != jsonData.constEnd(); ++it) {
-        if (it.key().startsWith("question_")) {
-            QJsonObject questionObj = it.value().toObject();
-            QuestionInfo info;
-            info.name = questionObj["name"].toString();
-            info.gender = questionObj["gender"].toString();
-            info.age = questionObj["age"].toString();
-            info.height = questionObj["height"].toString();
-            info.weight = questionObj["weight"].toString();
-            info.heart = questionObj["heart"].toString();
-            info.pressure = questionObj["pressure"].toString();
-            info.lung = questionObj["lung"].toString();
-            questions.append(info);
-        }
-    }
-    return questions;
+    return decodeRecords(jsonData, questionLayout);
 }
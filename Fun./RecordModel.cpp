@@ -0,0 +1,203 @@
+#include "RecordModel.h"
+#include <QHeaderView>
+#include <QSet>
+#include <QTableView>
+
+RecordModel::RecordModel(const QList<Column> &columns, KeyOf keyOf, QObject *parent) :
+    QAbstractTableModel(parent),
+    m_columns(columns),
+    m_keyOf(std::move(keyOf))
+{
+}
+
+int RecordModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int RecordModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_columns.size();
+}
+
+QVariant RecordModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size() || index.column() >= m_columns.size()) {
+        return QVariant();
+    }
+    const Row &row = m_rows[index.row()];
+    if (role == KeyRole) {
+        return row.key;
+    }
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) {
+        return QVariant();
+    }
+    const Column &column = m_columns[index.column()];
+    return column.format ? column.format(row.record) : row.record[column.field].toString();
+}
+
+QVariant RecordModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal || section >= m_columns.size()) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    return m_columns[section].title;
+}
+
+QList<QJsonObject> RecordModel::recordsIn(const QJsonObject &reply, const QString &prefix)
+{
+    QList<QJsonObject> records;
+    for (auto it = reply.constBegin(); it != reply.constEnd(); ++it) {
+        if (it.key().startsWith(prefix) && it.value().isObject()) {
+            records.append(it.value().toObject());
+        }
+    }
+    return records;
+}
+
+void RecordModel::sync(const QList<QJsonObject> &records)
+{
+    QSet<QString> keys;
+    QList<QJsonObject> added;
+    for (const QJsonObject &record : records) {
+        const QString key = m_keyOf(record);
+        if (keys.contains(key)) {
+            continue;
+        }
+        keys.insert(key);
+        auto it = m_index.constFind(key);
+        if (it == m_index.constEnd()) {
+            added.append(record);
+        } else if (m_rows[it.value()].record != record) {
+            m_rows[it.value()].record = record;
+            emit dataChanged(index(it.value(), 0), index(it.value(), m_columns.size() - 1));
+        }
+    }
+
+    // 从后往前删，连续的几行合成一次通知
+    int removedFrom = -1;
+    for (int end = m_rows.size() - 1; end >= 0;) {
+        if (keys.contains(m_rows[end].key)) {
+            --end;
+            continue;
+        }
+        int begin = end;
+        while (begin > 0 && !keys.contains(m_rows[begin - 1].key)) {
+            --begin;
+        }
+        beginRemoveRows(QModelIndex(), begin, end);
+        for (int i = begin; i <= end; ++i) {
+            m_index.remove(m_rows[i].key);
+        }
+        m_rows.remove(begin, end - begin + 1);
+        endRemoveRows();
+        removedFrom = begin;
+        end = begin - 1;
+    }
+    if (removedFrom >= 0) {
+        reindex(removedFrom);
+    }
+
+    if (!added.isEmpty()) {
+        const int first = m_rows.size();
+        beginInsertRows(QModelIndex(), first, first + added.size() - 1);
+        m_rows.reserve(first + added.size());
+        for (const QJsonObject &record : added) {
+            Row row{ m_keyOf(record), record };
+            m_index.insert(row.key, m_rows.size());
+            m_rows.append(row);
+        }
+        endInsertRows();
+    }
+}
+
+void RecordModel::upsert(const QJsonObject &record)
+{
+    const QString key = m_keyOf(record);
+    auto it = m_index.constFind(key);
+    if (it != m_index.constEnd()) {
+        const int row = it.value();
+        if (m_rows[row].record != record) {
+            m_rows[row].record = record;
+            emit dataChanged(index(row, 0), index(row, m_columns.size() - 1));
+        }
+        return;
+    }
+    beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size());
+    m_index.insert(key, m_rows.size());
+    m_rows.append(Row{ key, record });
+    endInsertRows();
+}
+
+void RecordModel::merge(const QJsonObject &fields)
+{
+    const int row = rowOf(m_keyOf(fields));
+    if (row < 0) {
+        upsert(fields);
+        return;
+    }
+    QJsonObject record = m_rows[row].record;
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        record[it.key()] = it.value();
+    }
+    upsert(record);
+}
+
+void RecordModel::remove(const QString &key)
+{
+    const int row = rowOf(key);
+    if (row < 0) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    m_index.remove(key);
+    m_rows.remove(row);
+    endRemoveRows();
+    reindex(row);
+}
+
+void RecordModel::clear()
+{
+    if (m_rows.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    m_rows.clear();
+    m_index.clear();
+    endResetModel();
+}
+
+int RecordModel::rowOf(const QString &key) const
+{
+    return m_index.value(key, -1);
+}
+
+QString RecordModel::keyAt(int row) const
+{
+    return row >= 0 && row < m_rows.size() ? m_rows[row].key : QString();
+}
+
+QJsonObject RecordModel::recordAt(int row) const
+{
+    return row >= 0 && row < m_rows.size() ? m_rows[row].record : QJsonObject();
+}
+
+void RecordModel::setupView(QTableView *view)
+{
+    view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    view->setSelectionMode(QAbstractItemView::SingleSelection);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setWordWrap(false);
+    view->verticalHeader()->hide();
+    view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    view->verticalHeader()->setDefaultSectionSize(view->fontMetrics().height() + 8);
+    view->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    view->horizontalHeader()->setStretchLastSection(true);
+}
+
+void RecordModel::reindex(int from)
+{
+    for (int i = from; i < m_rows.size(); ++i) {
+        m_index[m_rows[i].key] = i;
+    }
+}
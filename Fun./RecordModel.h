@@ -0,0 +1,72 @@
+#ifndef RECORDMODEL_H
+#define RECORDMODEL_H
+
+#include <QAbstractTableModel>
+#include <QJsonObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class QTableView;
+
+// 列表界面共用的表格模型：每行是服务器回复中的一条记录，按记录键索引。
+// 新的列表到达时用 sync 按键比对，只对新增、删除和内容有变的行发通知，视图只重绘这些行；
+// 显示文字在 data() 里按列现取，看不到的行不做格式化
+class RecordModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    using Format = std::function<QString(const QJsonObject &record)>;
+    using KeyOf = std::function<QString(const QJsonObject &record)>;
+
+    struct Column
+    {
+        QString title;
+        QString field;  // 直接显示该字段
+        Format format;  // 需要拼接或换算时使用，优先于 field
+    };
+
+    static constexpr int KeyRole = Qt::UserRole;  // 行的记录键
+
+    explicit RecordModel(const QList<Column> &columns, KeyOf keyOf, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // 回复中键以 prefix 开头的对象（如 "doctor_1"）
+    static QList<QJsonObject> recordsIn(const QJsonObject &reply, const QString &prefix);
+
+    void sync(const QList<QJsonObject> &records);  // 换成这份列表，顺序以新列表为准追加新行
+    void upsert(const QJsonObject &record);
+    void merge(const QJsonObject &fields);  // 按键改已有行中给出的字段，其余字段保留；没有该行时新增
+    void remove(const QString &key);
+    void clear();
+
+    int rowOf(const QString &key) const;  // 没有时返回 -1
+    QString keyAt(int row) const;
+    QJsonObject recordAt(int row) const;
+
+    // 行高固定、整行选择、不按内容算列宽，十万行也能流畅滚动
+    static void setupView(QTableView *view);
+
+private:
+    struct Row
+    {
+        QString key;
+        QJsonObject record;
+    };
+
+    void reindex(int from);
+
+    QList<Column> m_columns;
+    KeyOf m_keyOf;
+    QVector<Row> m_rows;
+    QHash<QString, int> m_index;  // 记录键 -> 行号
+};
+
+#endif // RECORDMODEL_H
@@ -31,7 +31,7 @@ void Function::handleUserCache(const QString &type, const QString &username, con
     qDebug()<<"handleUserCache:正在处理缓存...";
 
     // 判断文件是否存在且能够加载到内存
-    if (QFile::exists(filename) && UserSession::instance().loadUserInfoFromLocal(filename)) {
+    if (UserSession::instance().loadUserInfoFromLocal(filename)) {
         qDebug() << "handleUserCache:文件存在:" << filename;
     } else {
         qDebug() << "handleUserCache:文件不存在或加载失败，缓存新数据:" << filename;
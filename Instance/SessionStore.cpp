@@ -0,0 +1,147 @@
+#include "SessionStore.h"
+#include <QCborMap>
+#include <QCborValue>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDeadlineTimer>
+#include <QDebug>
+
+SessionStore::SessionStore() :
+    m_writing(false),
+    m_flushRequested(false),
+    m_stopping(false),
+    m_writes(0)
+{
+    setObjectName("SessionStore");
+    start(QThread::LowPriority);
+}
+
+SessionStore::~SessionStore()
+{
+    // 退出前写完剩下的快照
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    wait();
+}
+
+// 获取单例实例
+SessionStore& SessionStore::instance()
+{
+    static SessionStore instance;
+    return instance;
+}
+
+void SessionStore::save(const QString &path, const QMap<QString, QString> &info)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.insert(path, info);
+    m_wake.wakeAll();
+}
+
+void SessionStore::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_pending.isEmpty() || m_writing) {
+        m_flushRequested = true;  // 不必等合并的延时
+        m_wake.wakeAll();
+        m_idle.wait(&m_mutex);
+    }
+}
+
+void SessionStore::run()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (m_pending.isEmpty() && !m_stopping) {
+            m_wake.wait(&m_mutex);
+        }
+        if (m_pending.isEmpty()) {
+            break;
+        }
+        // 合并紧接着的修改：每次 save 都会唤醒这里，所以等到截止时间为止，只有 flush 或退出才提前结束
+        QDeadlineTimer deadline(coalesceMs);
+        while (!m_flushRequested && !m_stopping && !deadline.hasExpired()) {
+            m_wake.wait(&m_mutex, deadline);
+        }
+
+        QHash<QString, QMap<QString, QString>> batch;
+        batch.swap(m_pending);
+        m_flushRequested = false;
+        m_writing = true;
+        locker.unlock();
+        for (auto it = batch.constBegin(); it != batch.constEnd(); ++it) {
+            write(it.key(), it.value());
+            m_writes.ref();
+        }
+        locker.relock();
+        m_writing = false;
+        if (m_pending.isEmpty()) {
+            m_idle.wakeAll();
+        }
+    }
+    m_idle.wakeAll();
+}
+
+bool SessionStore::write(const QString &path, const QMap<QString, QString> &info)
+{
+    QCborMap map;
+    for (auto it = info.constBegin(); it != info.constEnd(); ++it) {
+        map.insert(it.key(), it.value());
+    }
+    QCborMap root;
+    root.insert(QStringLiteral("v"), formatVersion);
+    root.insert(QStringLiteral("info"), map);
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "SessionStore::write:无法写入缓存文件：" << path;
+        return false;
+    }
+    file.write(QCborValue(root).toCbor());
+    return file.commit();
+}
+
+bool SessionStore::load(const QString &path, QMap<QString, QString> &info)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+
+    // 映射失败（如某些虚拟文件系统）时退回普通读取
+    uchar *mapped = file.map(0, file.size());
+    QByteArray data = mapped ? QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(file.size()))
+                             : file.readAll();
+
+    QMap<QString, QString> result;
+    if (data.startsWith('{')) {
+        // 旧版 JSON 缓存
+        QJsonDocument doc = QJsonDocument::fromJson(data);
+        if (!doc.isObject()) {
+            return false;
+        }
+        const QJsonObject obj = doc.object();
+        for (auto it = obj.constBegin(); it != obj.constEnd(); ++it) {
+            result.insert(it.key(), it.value().toString());
+        }
+    } else {
+        QCborMap root = QCborValue::fromCbor(data).toMap();
+        if (root.value(QStringLiteral("v")).toInteger() != formatVersion) {
+            return false;
+        }
+        const QCborMap map = root.value(QStringLiteral("info")).toMap();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            result.insert(it.key().toString(), it.value().toString());
+        }
+    }
+    info.swap(result);
+    return true;
+}
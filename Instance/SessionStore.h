@@ -0,0 +1,50 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QMap>
+#include <QHash>
+#include <QString>
+
+// 用户信息缓存的后台写入：save 只记下最新的快照就返回，后台线程把短时间内的多次修改合并成一次写入，
+// 用 QSaveFile 写完整个文件再替换，写到一半崩溃也不会损坏原文件。
+// 文件为带版本号的 CBOR：{ "v": 1, "info": { 键: 值 } }，启动时用内存映射读取
+class SessionStore : public QThread
+{
+    Q_OBJECT
+
+public:
+    static constexpr int formatVersion = 1;
+    static constexpr int coalesceMs = 200;  // 第一次修改后等这么久再写，期间的修改一并写入
+
+    static SessionStore& instance();
+
+    void save(const QString &path, const QMap<QString, QString> &info);
+    void flush();  // 等待所有待写的快照写完
+    int writeCount() const { return m_writes.loadAcquire(); }  // 后台线程实际写文件的次数
+
+    // 读取缓存文件；兼容旧版的 JSON 格式
+    static bool load(const QString &path, QMap<QString, QString> &info);
+    static bool write(const QString &path, const QMap<QString, QString> &info);
+
+protected:
+    void run() override;
+
+private:
+    SessionStore();
+    ~SessionStore() override;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;  // 有新的快照或要退出
+    QWaitCondition m_idle;  // 待写的快照都已写完
+    QHash<QString, QMap<QString, QString>> m_pending;  // 路径 -> 最新快照
+    bool m_writing;
+    bool m_flushRequested;  // flush 在等，不必等满合并的延时
+    bool m_stopping;
+    QAtomicInt m_writes;
+};
+
+#endif // SESSIONSTORE_H
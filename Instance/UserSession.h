@@ -5,7 +5,10 @@
 #include <QJsonObject>
 #include<QFile>
 #include <QDir>
-#include<QThread>
+#include <QMap>
+#include <QRegularExpression>
+#include <QDebug>
+#include"SessionStore.h"
 
 class UserSession {
 public:
@@ -19,51 +22,13 @@ public:
         // 根据类型和用户名生成缓存文件路径
         filename = getCacheFilePath(type, username);
 
-        qDebug()<<"UserSession::setUserInfo:正在设置用户信息...";
-
-
-        //------------------------------------test--------------------------------------------------
-
-        //检查迭代器是否正常
-
+        // 遍历 QJsonObject，将所有 key-value 转成 QString 存入 Map（已有的 key 更新其值）
         for (auto it = personalInfo.begin(); it != personalInfo.end(); ++it) {
-            qDebug() << "Iterating: " << it.key() << ": " << it.value().toString();
-
+            userInfoMap.insert(it.key(), it.value().toString());
         }
+        qDebug() << "UserSession::setUserInfo:更新用户信息" << personalInfo.size() << "项";
 
-        //------------------------------------test--------------------------------------------------
-
-
-
-
-        // 遍历 QJsonObject，将所有 key-value 转成 QString 存入 Map
-        for (auto it = personalInfo.begin(); it != personalInfo.end(); ++it) {
-            // 如果 Map 中已经有这个 key，就更新其值
-            if (userInfoMap.contains(it.key())) {
-                userInfoMap[it.key()] = it.value().toString();
-
-                qDebug()<<"serUserInfo:更新"<<it.key()<<":"<<it.value().toString();
-
-            } else {
-                // 如果 Map 中没有这个 key，就新增
-                userInfoMap.insert(it.key(), it.value().toString());
-
-                qDebug()<<"serUserInfo:新增"<<it.key()<<":"<<it.value().toString();
-
-                //----------------------------------test-----------------------------------
-                //检查map是否正常
-
-                qDebug() << "userInfoMap contains key: " << userInfoMap.contains(it.key());
-
-                //----------------------------------test-----------------------------------
-            }
-        }
-
-        qDebug() << "UserSession::setUserInfo: 保存用户信息到本地文件...";
         saveUserInfoToLocal();
-        qDebug() << "UserSession::setUserInfo: 数据已保存";
-
-
     }
 
     QJsonObject getAllInfoAsJson() const {
@@ -92,51 +57,36 @@ public:
         return userInfoMap;
     }
 
+    // 交给后台线程写入，不阻塞界面；需要确认已落盘时调用 SessionStore::instance().flush()
     void saveUserInfoToLocal() {
-        QJsonObject obj = getAllInfoAsJson();
-        QFile file(filename);
-
-        //  输出文件保存的绝对路径
-        QString absolutePath = QDir::currentPath() + "/" + filename;
-        qDebug() << "saveUserInfoToLocal:Saving user info to: " << absolutePath;
-
-        if (file.open(QIODevice::WriteOnly)) {
-            file.write(QJsonDocument(obj).toJson());
-            file.close();
-        }
+        SessionStore::instance().save(filename, userInfoMap);
     }
 
     bool loadUserInfoFromLocal(const QString &filename) {
 
-        qDebug() << "loadUserInfoFromLocal: 线程" << QThread::currentThreadId() << "开始加载缓存文件：" << filename;
-
-        QFile file(filename);
-
-        if (!file.exists() || !file.open(QIODevice::ReadOnly)) return false;
+        qDebug() << "loadUserInfoFromLocal:开始加载缓存文件：" << filename;
 
-        qDebug()<<"loadUserInfoFromLocal:正在读取缓存...";
-        QByteArray data = file.readAll();
-        QJsonDocument doc = QJsonDocument::fromJson(data);
-        if (!doc.isObject()){
-
-        qDebug()<<"loadUserInfoFromLocal:文件为空，读取缓存失败";
-        return false;
-        };
-
-        QJsonObject obj = doc.object();
-        userInfoMap.clear(); // 先清空旧数据
-        for (auto it = obj.begin(); it != obj.end(); ++it) {
-            userInfoMap[it.key()] = it.value().toString();
+        QMap<QString, QString> info;
+        if (!SessionStore::load(filename, info)) {
+            // 旧版本留下的 .json 缓存：读出来后改存为新格式
+            QString legacy = filename;
+            legacy.replace(QRegularExpression("\\.cbor$"), ".json");
+            if (legacy == filename || !SessionStore::load(legacy, info)) {
+                qDebug()<<"loadUserInfoFromLocal:文件不存在或格式错误，读取缓存失败";
+                return false;
+            }
+            SessionStore::instance().save(filename, info);
+            QFile::remove(legacy);
         }
 
+        userInfoMap = info; // 替换旧数据
         qDebug()<<"loadUserInfoFromLocal:读取缓存成功!";
-        file.close();
         return true;
     }
 
     // 获取缓存文件的路径
     QString getCacheFilePath(const QString &type, const QString &username) const {
-        return "cache/" + type + "_" + username + "_local_user_info.json";
+        return "cache/" + type + "_" + username + "_local_user_info.cbor";
     }
 
 
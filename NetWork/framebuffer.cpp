@@ -0,0 +1,46 @@
+#include "framebuffer.h"
+
+FrameBuffer::FrameBuffer(int maxSize)
+    : m_maxSize(maxSize),
+    m_overflowed(false)
+{
+}
+
+QList<QByteArray> FrameBuffer::append(const QByteArray &data)
+{
+    QList<QByteArray> frames;
+    m_overflowed = false;
+    m_buffer.append(data);
+
+    // 从上次切完的位置往后找分隔符，避免每次都整段拷贝缓冲
+    qsizetype begin = 0;
+    for (qsizetype end; (end = m_buffer.indexOf('\n', begin)) >= 0; begin = end + 1) {
+        QByteArray frame = m_buffer.mid(begin, end - begin).trimmed();
+        if (!frame.isEmpty()) {
+            frames.append(frame);
+        }
+    }
+    m_buffer.remove(0, begin);
+
+    if (m_buffer.size() > m_maxSize) {
+        m_buffer.clear();
+        m_overflowed = true;
+    }
+    return frames;
+}
+
+bool FrameBuffer::overflowed() const
+{
+    return m_overflowed;
+}
+
+int FrameBuffer::pending() const
+{
+    return m_buffer.size();
+}
+
+void FrameBuffer::clear()
+{
+    m_buffer.clear();
+    m_overflowed = false;
+}
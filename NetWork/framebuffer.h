@@ -0,0 +1,30 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <QByteArray>
+#include <QList>
+
+// 接收缓冲：服务器每条回复以 '\n' 结尾，TCP 可能把多条回复粘在一起，
+// 也可能把一条大回复拆成几段，这里按 '\n' 切出完整的帧，未结束的部分留到下次
+class FrameBuffer
+{
+public:
+    static constexpr int defaultMaxSize = 16 * 1024 * 1024;
+
+    explicit FrameBuffer(int maxSize = defaultMaxSize);
+
+    // 追加收到的字节，返回其中所有完整的帧（不含 '\n'，跳过空帧）；
+    // 未结束的帧超过上限时丢弃缓冲并置 overflowed
+    QList<QByteArray> append(const QByteArray &data);
+
+    bool overflowed() const;
+    int pending() const;  // 缓冲中尚未结束的字节数
+    void clear();
+
+private:
+    QByteArray m_buffer;
+    int m_maxSize;
+    bool m_overflowed;
+};
+
+#endif // FRAMEBUFFER_H
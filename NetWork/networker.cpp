@@ -0,0 +1,127 @@
+#include "networker.h"
+#include <QJsonDocument>
+#include <QDebug>
+
+NetWorker::NetWorker(QObject *parent) : QObject(parent),
+    m_socket(nullptr),
+    m_state(QAbstractSocket::UnconnectedState)
+{
+}
+
+QAbstractSocket::SocketState NetWorker::state() const
+{
+    return static_cast<QAbstractSocket::SocketState>(m_state.load());
+}
+
+void NetWorker::start()
+{
+    // socket 必须在使用它的线程中创建
+    m_socket = new QTcpSocket(this);
+    connect(m_socket, &QTcpSocket::readyRead, this, &NetWorker::onReadyRead);
+    connect(m_socket, &QTcpSocket::connected, this, &NetWorker::connected);
+    connect(m_socket, &QTcpSocket::disconnected, this, &NetWorker::disconnected);
+    connect(m_socket, &QTcpSocket::errorOccurred, this, &NetWorker::onError);
+    connect(m_socket, &QTcpSocket::stateChanged, this, [this](QAbstractSocket::SocketState state) {
+        m_state.store(state);
+    });
+    qDebug() << "NetWorker: Socket 创建成功。";
+}
+
+void NetWorker::connectToHost(const QString &host, int port)
+{
+    // 如果已经连接，先断开；在网络线程里等待不会卡住界面
+    if (m_socket->state() == QAbstractSocket::ConnectedState) {
+        m_socket->disconnectFromHost();
+        if (m_socket->state() != QAbstractSocket::UnconnectedState) {
+            m_socket->waitForDisconnected(1000);
+        }
+        qDebug() << "NetWorker::connectToHost:tcp已有连接，正在断开...";
+    }
+    // 上一次还没连上的尝试直接放弃（重连时每次尝试都会重新调用）
+    if (m_socket->state() != QAbstractSocket::UnconnectedState) {
+        m_socket->abort();
+    }
+
+    // 新连接不能接上旧连接没收完的半条回复
+    m_frames.clear();
+
+    qDebug() << "NetWorker::connectToHost:尝试连接到服务器：" << host << "端口：" << port;
+    m_socket->connectToHost(host, port);
+}
+
+void NetWorker::write(const QByteArray &data)
+{
+    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+        qDebug() << "NetWorker::write:未连接到服务器，丢弃待发送的数据。";
+        return;
+    }
+    m_socket->write(data);
+    m_socket->flush();
+}
+
+void NetWorker::disconnectFromHost()
+{
+    if (m_socket) {
+        m_socket->disconnectFromHost();
+    }
+}
+
+void NetWorker::abort()
+{
+    if (m_socket) {
+        m_socket->abort();
+    }
+}
+
+void NetWorker::onReadyRead()
+{
+    QByteArray data = m_socket->readAll();
+    emit dataArrived();
+
+    // 一次可能读到多条回复，也可能只读到一条回复的一部分
+    const QList<QByteArray> frames = m_frames.append(data);
+    if (m_frames.overflowed()) {
+        qWarning() << "NetWorker::onReadyRead:单条回复超过接收缓冲上限，已丢弃";
+        emit replyTooLarge();
+    }
+    for (const QByteArray &frame : frames) {
+        QJsonObject reply;
+        bool hasId = false;
+        quint64 id = 0;
+        if (!decode(frame, reply, hasId, id)) {
+            qWarning() << "NetWorker::onReadyRead:接收到的数据无法转换为 QJsonObject：" << frame.left(256);
+            continue;
+        }
+        emit replyDecoded(reply, hasId, id);
+    }
+}
+
+void NetWorker::onError(QAbstractSocket::SocketError socketError)
+{
+    qDebug() << "NetWorker:发生 socket 错误：" << m_socket->errorString() << "错误代码：" << socketError;
+    emit errorOccurred(m_socket->errorString());
+}
+
+bool NetWorker::decode(const QByteArray &frame, QJsonObject &reply, bool &hasId, quint64 &id)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(frame);
+    if (!doc.isObject()) {
+        return false;
+    }
+    QJsonObject response = doc.object();
+
+    // data 中的字段和 reply 合并成一个对象，窗口按字段名取值；同名时以 data 为准
+    reply = response["data"].toObject();
+    if (!reply.contains("reply")) {
+        reply["reply"] = response["reply"].toString();
+    }
+
+    // 可缓存查询的内容版本，由 TcpClient 取走
+    if (response.contains("version")) {
+        reply["version"] = response["version"];
+    }
+
+    hasId = response.contains("id");
+    id = hasId ? response["id"].toVariant().toULongLong() : 0;
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef NETWORKER_H
+#define NETWORKER_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QJsonObject>
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include"framebuffer.h"
+
+// 网络线程：socket 的读写、按 '\n' 分帧、JSON 解析和 reply/data 字段的合并都在这里做，
+// 界面线程只收到解析好的 QJsonObject（经排队信号传递），不再接触原始字节。
+// 由 TcpClient 创建并移到自己的 QThread 中，只能通过排队调用使用其槽函数
+class NetWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetWorker(QObject *parent = nullptr);
+
+    // 连接状态，任意线程可读
+    QAbstractSocket::SocketState state() const;
+
+    // 解析一帧回复，把 reply 和 data 中的字段合并到 reply；带请求 id 时 hasId 置 true。
+    // 不是 JSON 对象时返回 false
+    static bool decode(const QByteArray &frame, QJsonObject &reply, bool &hasId, quint64 &id);
+
+public slots:
+    void start();  // 在网络线程中创建 socket
+    void connectToHost(const QString &host, int port);
+    void write(const QByteArray &data);
+    void disconnectFromHost();
+    void abort();  // 立即丢弃连接（不等待待发数据写完），用于放弃失效的连接
+
+signals:
+    void connected();
+    void disconnected();
+    void errorOccurred(const QString &error);
+    void dataArrived();  // 收到任何字节（哪怕不是完整的一帧）
+    void replyDecoded(const QJsonObject &reply, bool hasId, quint64 id);
+    void replyTooLarge();
+
+private slots:
+    void onReadyRead();
+    void onError(QAbstractSocket::SocketError socketError);
+
+private:
+    QTcpSocket *m_socket;
+    FrameBuffer m_frames;  // 接收缓冲，按 '\n' 切分回复
+    std::atomic<int> m_state;
+};
+
+#endif // NETWORKER_H
@@ -0,0 +1,219 @@
+#include "recordstore.h"
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+
+RecordStore::RecordStore() :
+    m_dir("cache"),
+    m_frames(0)
+{
+}
+
+// 获取单例实例
+RecordStore& RecordStore::instance()
+{
+    static RecordStore instance;
+    return instance;
+}
+
+QString RecordStore::kindFor(const QString &command)
+{
+    static const QHash<QString, QString> kinds = {
+        { "queryCaseList", "case" },
+        { "queryAdviceList", "advice" },
+    };
+    return kinds.value(command);
+}
+
+void RecordStore::open(const QString &type, const QString &username)
+{
+    const QString path = m_dir + '/' + type + '_' + username + "_records.log";
+    if (path == m_path) {
+        return;
+    }
+    m_path = path;
+    m_tables.clear();
+    load();
+}
+
+void RecordStore::setDirectory(const QString &dir)
+{
+    m_dir = dir;
+    m_path.clear();
+    m_tables.clear();
+    m_frames = 0;
+}
+
+bool RecordStore::hasSynced(const QString &kind) const
+{
+    auto it = m_tables.constFind(kind);
+    return it != m_tables.constEnd() && it->synced;
+}
+
+QString RecordStore::watermark(const QString &kind) const
+{
+    return m_tables.value(kind).watermark;
+}
+
+QList<QJsonObject> RecordStore::records(const QString &kind) const
+{
+    return m_tables.value(kind).rows.values();
+}
+
+QJsonObject RecordStore::reply(const QString &kind) const
+{
+    const Table table = m_tables.value(kind);
+    QJsonObject ret;
+    ret["reply"] = "successful";
+    int i = 0;
+    for (auto it = table.rows.constBegin(); it != table.rows.constEnd(); ++it) {
+        ret[kind + '_' + QString::number(++i)] = it.value();
+    }
+    ret["watermark"] = table.watermark;
+    return ret;
+}
+
+int RecordStore::merge(const QString &kind, const QJsonObject &reply)
+{
+    if (!reply.contains("watermark")) {
+        return -1;
+    }
+    Table &table = m_tables[kind];
+    const QString prefix = kind + '_';
+    QList<QJsonObject> changed;
+    for (auto it = reply.constBegin(); it != reply.constEnd(); ++it) {
+        if (!it.key().startsWith(prefix)) {
+            continue;
+        }
+        const QJsonObject row = it.value().toObject();
+        const qint64 id = row["id"].toVariant().toLongLong();
+        auto old = table.rows.constFind(id);
+        if (old == table.rows.constEnd() || old.value() != row) {
+            table.rows.insert(id, row);
+            changed.append(row);
+        }
+    }
+
+    // 水位之前的重叠部分会重复发来，内容没变就不必写盘
+    const QString watermark = reply["watermark"].toString();
+    if (changed.isEmpty() && table.synced && watermark == table.watermark) {
+        return 0;
+    }
+    table.synced = true;
+    table.watermark = watermark;
+
+    if (append(frame(kind, watermark, changed)) && ++m_frames > compactAfter) {
+        compact();
+    }
+    return changed.size();
+}
+
+void RecordStore::clear()
+{
+    m_tables.clear();
+    m_frames = 0;
+    if (!m_path.isEmpty()) {
+        QFile::remove(m_path);
+    }
+}
+
+QByteArray RecordStore::frame(const QString &kind, const QString &watermark, const QList<QJsonObject> &rows)
+{
+    QCborArray array;
+    for (const QJsonObject &row : rows) {
+        array.append(QCborMap::fromJsonObject(row));
+    }
+    QCborMap map;
+    map.insert(QStringLiteral("v"), formatVersion);
+    map.insert(QStringLiteral("kind"), kind);
+    map.insert(QStringLiteral("watermark"), watermark);
+    map.insert(QStringLiteral("rows"), array);
+
+    const QByteArray body = QCborValue(map).toCbor();
+    QByteArray ret(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(body.size(), ret.data());
+    return ret + body;
+}
+
+void RecordStore::load()
+{
+    m_frames = 0;
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // 映射失败时退回普通读取
+    const qint64 size = file.size();
+    uchar *mapped = size > 0 ? file.map(0, size) : nullptr;
+    const QByteArray data = mapped ? QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(size))
+                                   : file.readAll();
+
+    qint64 pos = 0;
+    while (pos + 4 <= data.size()) {
+        const quint32 length = qFromBigEndian<quint32>(data.constData() + pos);
+        if (length > quint64(data.size() - pos - 4)) {
+            break;
+        }
+        QCborParserError error;
+        const QCborMap map = QCborValue::fromCbor(data.constData() + pos + 4, length, &error).toMap();
+        if (error.error != QCborError::NoError || map.value(QStringLiteral("v")).toInteger() != formatVersion) {
+            break;
+        }
+
+        Table &table = m_tables[map.value(QStringLiteral("kind")).toString()];
+        table.synced = true;
+        table.watermark = map.value(QStringLiteral("watermark")).toString();
+        const QCborArray rows = map.value(QStringLiteral("rows")).toArray();
+        for (const QCborValue &value : rows) {
+            const QJsonObject row = value.toMap().toJsonObject();
+            table.rows.insert(row["id"].toVariant().toLongLong(), row);
+        }
+        pos += 4 + length;
+        ++m_frames;
+    }
+
+    if (pos < size) {
+        // 上次追加到一半就退出了（或文件已损坏），之后的内容不可信
+        qWarning() << "RecordStore::load:截掉日志末尾无法解析的" << size - pos << "字节：" << m_path;
+        file.close();
+        QFile::resize(m_path, pos);
+    }
+    qDebug() << "RecordStore::load:载入" << m_path << "共" << m_frames << "批";
+}
+
+bool RecordStore::append(const QByteArray &frame)
+{
+    if (m_path.isEmpty()) {
+        return false;
+    }
+    QDir().mkpath(m_dir);
+    QFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "RecordStore::append:无法写入本地库：" << m_path;
+        return false;
+    }
+    return file.write(frame) == frame.size();
+}
+
+void RecordStore::compact()
+{
+    QSaveFile file(m_path);  // 写完再替换，中途退出时原日志仍完整
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "RecordStore::compact:无法写入本地库：" << m_path;
+        return;
+    }
+    for (auto it = m_tables.constBegin(); it != m_tables.constEnd(); ++it) {
+        if (it->synced) {
+            file.write(frame(it.key(), it->watermark, it->rows.values()));
+        }
+    }
+    if (file.commit()) {
+        m_frames = m_tables.size();
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef RECORDSTORE_H
+#define RECORDSTORE_H
+
+#include <QJsonObject>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QString>
+
+// 本地记录库：当前用户的病历和医嘱存在 cache/<类型>_<用户名>_records.log，断网时也能浏览。
+// 打开时整个读进内存，读取不经过网络和磁盘；每次同步只向服务器要上次水位（watermark）之后改过的行，
+// 按 id 合并后把这一批追加到日志末尾，批次多了再重写成一份快照。
+// 日志由若干帧组成：4 字节大端长度 + CBOR { "v": 1, "kind": 种类, "watermark": 水位, "rows": [行] }，
+// 末尾写到一半的帧在下次打开时截掉
+class RecordStore
+{
+public:
+    static constexpr int formatVersion = 1;
+    static constexpr int compactAfter = 64;  // 日志超过这么多帧时重写成快照
+
+    static RecordStore& instance();
+
+    // 命令对应的记录种类（"case"、"advice"），不走本地库的命令返回空串
+    static QString kindFor(const QString &command);
+
+    void open(const QString &type, const QString &username);  // 切换到某个用户的库，已打开时不重复读取
+    void setDirectory(const QString &dir);  // 默认 cache
+
+    bool hasSynced(const QString &kind) const;  // 是否同步过（同步过但没有记录也算）
+    QString watermark(const QString &kind) const;
+    QList<QJsonObject> records(const QString &kind) const;  // 按 id 排序
+    // 与服务器完整回复格式相同：{ "reply": "successful", "case_1": {...}, ... }
+    QJsonObject reply(const QString &kind) const;
+
+    // 合并服务器回复中的行，返回新增或内容有变的行数；回复不带水位（旧服务器）时不合并，返回 -1
+    int merge(const QString &kind, const QJsonObject &reply);
+    void clear();  // 删除当前用户的本地库
+
+private:
+    RecordStore();
+
+    struct Table
+    {
+        bool synced = false;
+        QString watermark;
+        QMap<qint64, QJsonObject> rows;  // id -> 行
+    };
+
+    void load();
+    bool append(const QByteArray &frame);
+    void compact();
+    static QByteArray frame(const QString &kind, const QString &watermark, const QList<QJsonObject> &rows);
+
+    QHash<QString, Table> m_tables;
+    QString m_dir;
+    QString m_path;
+    int m_frames;  // 日志中的帧数
+};
+
+#endif // RECORDSTORE_H
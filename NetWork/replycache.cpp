@@ -0,0 +1,200 @@
+#include "replycache.h"
+#include <QCborMap>
+#include <QCborArray>
+#include <QCborValue>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStringList>
+#include <QDebug>
+
+ReplyCache::ReplyCache(QObject *parent) : QObject(parent),
+    m_path("cache/reply_cache.cbor"),
+    m_loaded(false)
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(2000);
+    connect(&m_saveTimer, &QTimer::timeout, this, &ReplyCache::save);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+            if (m_saveTimer.isActive()) {
+                m_saveTimer.stop();
+                save();
+            }
+        });
+    }
+}
+
+// 获取单例实例
+ReplyCache& ReplyCache::instance()
+{
+    static ReplyCache instance;
+    return instance;
+}
+
+int ReplyCache::ttl(const QString &command)
+{
+    static const QHash<QString, int> ttls = {
+        { "queryDoctorList", 5 * 60 * 1000 },
+        { "queryDoctorInfo", 10 * 60 * 1000 },
+        { "queryNoticeList", 60 * 1000 },
+    };
+    return ttls.value(command, 0);
+}
+
+QString ReplyCache::key(const QString &command, const QJsonObject &data)
+{
+    // QJsonObject 的键是有序的，相同参数序列化结果相同
+    return command + ':' + QString::fromUtf8(QJsonDocument(data).toJson(QJsonDocument::Compact));
+}
+
+bool ReplyCache::lookup(const QString &command, const QJsonObject &data, Entry &entry)
+{
+    load();
+    auto it = m_entries.constFind(key(command, data));
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+    if (QDateTime::currentMSecsSinceEpoch() - it->storedAt > ttl(command) + maxStale) {
+        return false;
+    }
+    entry = it.value();
+    return true;
+}
+
+bool ReplyCache::isFresh(const QString &command, const Entry &entry) const
+{
+    return QDateTime::currentMSecsSinceEpoch() - entry.storedAt < ttl(command);
+}
+
+void ReplyCache::store(const QString &command, const QJsonObject &data, const QJsonObject &reply, const QString &version)
+{
+    load();
+    m_entries.insert(key(command, data), Entry{ reply, version, QDateTime::currentMSecsSinceEpoch() });
+
+    // 超出上限时丢掉最旧的
+    while (m_entries.size() > maxEntries) {
+        auto oldest = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->storedAt < oldest->storedAt) {
+                oldest = it;
+            }
+        }
+        m_entries.erase(oldest);
+    }
+    scheduleSave();
+}
+
+void ReplyCache::touch(const QString &command, const QJsonObject &data)
+{
+    load();
+    auto it = m_entries.find(key(command, data));
+    if (it != m_entries.end()) {
+        it->storedAt = QDateTime::currentMSecsSinceEpoch();
+        scheduleSave();
+    }
+}
+
+void ReplyCache::invalidateFor(const QString &command)
+{
+    static const QHash<QString, QStringList> affects = {
+        { "modifyDoctorInfo", { "queryDoctorInfo", "queryDoctorList" } },
+        { "modifyadminInfoClient", { "queryDoctorInfo", "queryDoctorList" } },
+        { "modifyNotice", { "queryNoticeList" } },
+        { "notice", { "queryNoticeList" } },  // 通知推送
+    };
+    auto affected = affects.constFind(command);
+    if (affected == affects.constEnd()) {
+        return;
+    }
+    load();
+    bool changed = false;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (affected->contains(it.key().section(':', 0, 0))) {
+            it = m_entries.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+    if (changed) {
+        scheduleSave();
+    }
+}
+
+void ReplyCache::clear()
+{
+    m_entries.clear();
+    m_loaded = true;
+    scheduleSave();
+}
+
+int ReplyCache::size() const
+{
+    return m_entries.size();
+}
+
+void ReplyCache::setPath(const QString &path)
+{
+    m_path = path;
+    m_entries.clear();
+    m_loaded = false;
+}
+
+void ReplyCache::scheduleSave()
+{
+    m_saveTimer.start();
+}
+
+// 文件格式：{ "v": 1, "entries": { 键: [写入时间, 版本, 回复] } }
+void ReplyCache::load()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QCborMap root = QCborValue::fromCbor(file.readAll()).toMap();
+    if (root.value(QStringLiteral("v")).toInteger() != 1) {
+        qDebug() << "ReplyCache::load:缓存文件格式不符，忽略：" << m_path;
+        return;
+    }
+    const QCborMap entries = root.value(QStringLiteral("entries")).toMap();
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        const QCborArray e = it.value().toArray();
+        if (e.size() != 3) {
+            continue;
+        }
+        m_entries.insert(it.key().toString(),
+                         Entry{ e[2].toMap().toJsonObject(), e[1].toString(), e[0].toInteger() });
+    }
+    qDebug() << "ReplyCache::load:载入缓存" << m_entries.size() << "条";
+}
+
+void ReplyCache::save()
+{
+    QCborMap entries;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        entries.insert(it.key(), QCborArray{ it->storedAt, it->version, QCborMap::fromJsonObject(it->reply) });
+    }
+    QCborMap root;
+    root.insert(QStringLiteral("v"), 1);
+    root.insert(QStringLiteral("entries"), entries);
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);  // 写完再替换，中途退出不会留下半个文件
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "ReplyCache::save:无法写入缓存文件：" << m_path;
+        return;
+    }
+    file.write(QCborValue(root).toCbor());
+    file.commit();
+}
@@ -0,0 +1,58 @@
+#ifndef REPLYCACHE_H
+#define REPLYCACHE_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QHash>
+#include <QString>
+#include <QTimer>
+
+// 回复缓存：按 (命令, 参数) 缓存查询回复，每个命令有自己的有效期，保存在 cache/ 下的 CBOR 文件里，重启后仍可用。
+// 有效期内直接用缓存，不发请求；过期后先用缓存渲染，同时带上缓存的版本号向服务器验证，
+// 内容没变服务器只回 notModified，变了才回完整内容并更新缓存
+class ReplyCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry
+    {
+        QJsonObject reply;
+        QString version;   // 服务器给出的内容版本
+        qint64 storedAt;   // 写入或最近一次验证的时间（毫秒）
+    };
+
+    static constexpr int maxEntries = 256;
+    static constexpr qint64 maxStale = 7LL * 24 * 3600 * 1000;  // 过期超过这么久的缓存不再使用
+
+    static ReplyCache& instance();
+
+    // 命令的有效期（毫秒），0 表示该命令不缓存
+    static int ttl(const QString &command);
+    static QString key(const QString &command, const QJsonObject &data);
+
+    bool lookup(const QString &command, const QJsonObject &data, Entry &entry);
+    bool isFresh(const QString &command, const Entry &entry) const;
+    void store(const QString &command, const QJsonObject &data, const QJsonObject &reply, const QString &version);
+    void touch(const QString &command, const QJsonObject &data);  // 服务器确认内容没变，重新计时
+    // 发出写请求（或收到相关推送）时，丢掉受其影响的查询的缓存，之后的查询会重新向服务器要
+    void invalidateFor(const QString &command);
+    void clear();
+    int size() const;
+
+    void setPath(const QString &path);  // 默认 cache/reply_cache.cbor
+    void save();
+
+private:
+    explicit ReplyCache(QObject *parent = nullptr);
+
+    void load();
+    void scheduleSave();
+
+    QHash<QString, Entry> m_entries;
+    QString m_path;
+    bool m_loaded;
+    QTimer m_saveTimer;  // 合并短时间内的多次写入
+};
+
+#endif // REPLYCACHE_H
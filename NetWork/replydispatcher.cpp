@@ -0,0 +1,139 @@
+#include "replydispatcher.h"
+#include <QDebug>
+
+ReplyDispatcher::ReplyDispatcher(QObject *parent) : QObject(parent)
+{
+}
+
+// 获取单例实例
+ReplyDispatcher& ReplyDispatcher::instance()
+{
+    static ReplyDispatcher instance;
+    return instance;
+}
+
+void ReplyDispatcher::route(WidgetState state, QObject *receiver, Handler handler)
+{
+    watch(receiver);
+    m_states.insert(static_cast<int>(state), Route{ receiver, std::move(handler) });
+}
+
+void ReplyDispatcher::routePush(const QString &reply, QObject *receiver, Handler handler)
+{
+    watch(receiver);
+    m_pushes.insert(reply, Route{ receiver, std::move(handler) });
+}
+
+void ReplyDispatcher::expect(quint64 id, QObject *context, Handler handler)
+{
+    m_pending.insert(id, Pending{ std::move(handler), context, context != nullptr, WidgetState::Idle });
+}
+
+void ReplyDispatcher::track(quint64 id, WidgetState state)
+{
+    m_pending.insert(id, Pending{ nullptr, nullptr, false, state });
+}
+
+void ReplyDispatcher::cancel(quint64 id)
+{
+    m_pending.remove(id);
+}
+
+int ReplyDispatcher::pending() const
+{
+    return m_pending.size();
+}
+
+bool ReplyDispatcher::isPending(quint64 id) const
+{
+    return m_pending.contains(id);
+}
+
+bool ReplyDispatcher::finish(quint64 id, const QJsonObject &reply)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) {
+        qDebug() << "ReplyDispatcher::finish:请求" << id << "已结束或已取消，丢弃回复";
+        return false;
+    }
+    Pending request = it.value();
+    m_pending.erase(it);
+
+    if (request.handler) {
+        if (request.hasContext && !request.context) {
+            qDebug() << "ReplyDispatcher::finish:请求" << id << "的接收方已销毁，丢弃回复";
+            return true;
+        }
+        request.handler(reply);
+        return true;
+    }
+    auto route = m_states.constFind(static_cast<int>(request.state));
+    return deliver(route == m_states.constEnd() ? nullptr : &route.value(), reply);
+}
+
+bool ReplyDispatcher::push(const QJsonObject &reply)
+{
+    auto route = m_pushes.constFind(reply["reply"].toString());
+    if (route != m_pushes.constEnd()) {
+        return deliver(&route.value(), reply);
+    }
+    // 旧的推送（如聊天消息）没有专门的路由，交给当前状态的处理者
+    auto state = m_states.constFind(static_cast<int>(StateManager::instance().currentState()));
+    return deliver(state == m_states.constEnd() ? nullptr : &state.value(), reply);
+}
+
+void ReplyDispatcher::failAll(const QString &reply)
+{
+    const QList<quint64> ids = m_pending.keys();
+    for (quint64 id : ids) {
+        auto it = m_pending.find(id);
+        if (it == m_pending.end()) {
+            continue;  // 前面的 handler 里已取消
+        }
+        if (it->handler) {
+            finish(id, QJsonObject{ { "reply", reply } });
+        } else {
+            m_pending.erase(it);
+        }
+    }
+}
+
+bool ReplyDispatcher::deliver(const Route *route, const QJsonObject &reply)
+{
+    if (!route) {
+        qDebug() << "ReplyDispatcher::deliver:没有窗口处理该回复，丢弃：" << reply["reply"].toString();
+        return false;
+    }
+    // 处理者里可能登记新的路由，先拷贝一份再调用
+    Handler handler = route->handler;
+    handler(reply);
+    return true;
+}
+
+void ReplyDispatcher::watch(QObject *receiver)
+{
+    if (!receiver || m_watched.contains(receiver)) {
+        return;
+    }
+    m_watched.insert(receiver);
+    connect(receiver, &QObject::destroyed, this, [this, receiver]() { forget(receiver); });
+}
+
+void ReplyDispatcher::forget(QObject *receiver)
+{
+    m_watched.remove(receiver);
+    for (auto it = m_states.begin(); it != m_states.end();) {
+        if (it->receiver == receiver) {
+            it = m_states.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_pushes.begin(); it != m_pushes.end();) {
+        if (it->receiver == receiver) {
+            it = m_pushes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef REPLYDISPATCHER_H
+#define REPLYDISPATCHER_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QHash>
+#include <QSet>
+#include <QPointer>
+#include <QString>
+#include <functional>
+#include"../Instance/StateManager.h"
+
+// 回复分发：每条回复只交给一个处理者，查表 O(1)，不再广播给所有窗口各自判断状态。
+// 1. TcpClient::request 发出的请求：回复交给该请求自己的 handler；
+// 2. sendData 发出的请求：记下发送时的 WidgetState，回复交给登记了该状态的窗口；
+// 3. 服务器主动推送（不带请求 id）：按 reply 字段找推送路由，找不到时按当前状态分发。
+// 登记的窗口销毁时自动注销
+class ReplyDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Handler = std::function<void(const QJsonObject &reply)>;
+
+    static ReplyDispatcher& instance();
+
+    // 状态为 state 时发出的请求，其回复交给 receiver；同一状态只保留最后登记的处理者
+    void route(WidgetState state, QObject *receiver, Handler handler);
+    template<typename T>
+    void route(WidgetState state, T *receiver, void (T::*slot)(const QJsonObject &))
+    {
+        route(state, receiver, [receiver, slot](const QJsonObject &reply) { (receiver->*slot)(reply); });
+    }
+
+    // reply 字段为 reply 的推送交给 receiver（如 "notice"、"change"）
+    void routePush(const QString &reply, QObject *receiver, Handler handler);
+
+    // 登记一个请求：expect 指定自己的 handler，track 按发送时的状态分发
+    void expect(quint64 id, QObject *context, Handler handler);
+    void track(quint64 id, WidgetState state);
+    void cancel(quint64 id);
+    int pending() const;
+    bool isPending(quint64 id) const;  // 请求还在等回复（未完成、未取消、未超时）
+
+    // 分发请求 id 为 id 的回复；请求已结束或已取消时返回 false
+    bool finish(quint64 id, const QJsonObject &reply);
+    // 分发一条推送；没有处理者时返回 false
+    bool push(const QJsonObject &reply);
+    // 以 reply 结束所有 expect 登记的请求（如连接断开），track 的请求直接丢弃
+    void failAll(const QString &reply);
+
+private:
+    explicit ReplyDispatcher(QObject *parent = nullptr);
+
+    struct Route
+    {
+        QObject *receiver;
+        Handler handler;
+    };
+    struct Pending
+    {
+        Handler handler;            // expect 登记的处理者；为空时按 state 分发
+        QPointer<QObject> context;
+        bool hasContext;
+        WidgetState state;
+    };
+
+    void watch(QObject *receiver);
+    void forget(QObject *receiver);  // receiver 销毁时注销它的所有路由
+    bool deliver(const Route *route, const QJsonObject &reply);
+
+    QHash<int, Route> m_states;      // WidgetState -> 处理者
+    QHash<QString, Route> m_pushes;  // 推送的 reply -> 处理者
+    QHash<quint64, Pending> m_pending;
+    QSet<QObject*> m_watched;
+};
+
+#endif // REPLYDISPATCHER_H
@@ -1,6 +1,9 @@
 #include "TcpClient.h"
 #include <QDebug>
 #include <QByteArray>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QStringList>
 
 // 静态成员变量初始化（放在所有函数之外）
 TcpClient* TcpClient::m_instance = nullptr;
@@ -14,17 +17,33 @@ TcpClient* TcpClient::instance()
 }
 
 TcpClient::TcpClient(QObject *parent) : QObject(parent),
+    m_nextId(1),
+    m_port(0),
+    m_autoReconnect(true),
+    m_wasConnected(false),
+    m_reconnecting(false),
+    m_attempt(0),
+    m_resumeId(0),
     timeoutDuration(10000)  // 默认超时为10秒
 {
 
-    // 创建 TcpClient 对象时，初始化 socket 对象并记录日志
-    qDebug() << "TcpClient: Socket 创建成功。";
-
-    socket = new QTcpSocket(this);
-    connect(socket, &QTcpSocket::readyRead, this, &TcpClient::onReadyRead);
-    connect(socket, &QTcpSocket::connected, this, &TcpClient::onConnected);
-    connect(socket, &QTcpSocket::disconnected, this, &TcpClient::onDisconnected);
-    connect(socket, &QTcpSocket::errorOccurred, this, &TcpClient::onError);
+    // socket 的读写和回复解析放在单独的网络线程，界面线程只收解析好的结果
+    qRegisterMetaType<quint64>("quint64");
+    m_thread = new QThread(this);
+    m_thread->setObjectName("TcpClientNetwork");
+    m_worker = new NetWorker;
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::started, m_worker, &NetWorker::start);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    // 跨线程连接，均为排队调用
+    connect(m_worker, &NetWorker::dataArrived, this, &TcpClient::onDataArrived);
+    connect(m_worker, &NetWorker::replyDecoded, this, &TcpClient::onReplyDecoded);
+    connect(m_worker, &NetWorker::replyTooLarge, this, &TcpClient::onReplyTooLarge);
+    connect(m_worker, &NetWorker::connected, this, &TcpClient::onConnected);
+    connect(m_worker, &NetWorker::disconnected, this, &TcpClient::onDisconnected);
+    connect(m_worker, &NetWorker::errorOccurred, this, &TcpClient::onError);
+    m_thread->start();
 
     // 初始化定时器
     timeoutTimer = new QTimer(this);
@@ -33,6 +52,9 @@ TcpClient::TcpClient(QObject *parent) : QObject(parent),
     timeoutTimerSend = new QTimer(this);
     timeoutTimerSend->setSingleShot(true);
     connect(timeoutTimerSend, &QTimer::timeout, this, &TcpClient::onTimeout);
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &TcpClient::onReconnectTimer);
 }
 
 
@@ -45,7 +67,7 @@ TcpClient::~TcpClient()
     qDebug() << "TcpClient: 析构函数调用，正在清理资源...";
 
     // Disconnect all signals first
-    disconnect(socket, nullptr, this, nullptr);
+    disconnect(m_worker, nullptr, this, nullptr);
     disconnect(timeoutTimer, nullptr, this, nullptr);
     disconnect(timeoutTimerSend, nullptr, this, nullptr);
 
@@ -66,14 +88,11 @@ TcpClient::~TcpClient()
         timeoutTimerSend = nullptr;
     }
 
-    // Delete socket safely
-    if (socket) {
-        if (socket->state() != QAbstractSocket::UnconnectedState) {
-            socket->disconnectFromHost();
-            socket->waitForDisconnected(1000);
-        }
-        delete socket;
-        socket = nullptr;
+    // 先在网络线程里断开连接，再结束线程；线程结束后 m_worker 随之销毁
+    if (m_thread->isRunning()) {
+        QMetaObject::invokeMethod(m_worker, "disconnectFromHost", Qt::BlockingQueuedConnection);
+        m_thread->quit();
+        m_thread->wait();
     }
 
     qDebug() << "TcpClient: 资源清理完成。";
@@ -88,27 +107,21 @@ void TcpClient::connectToServer(const QString &host, int port)
 
      // QMutexLocker locker(&m_mutex);
 
-    // 如果已经连接，先断开
-    if (socket->state() == QAbstractSocket::ConnectedState) {
-        socket->disconnectFromHost();
-        socket->waitForDisconnected(1000);
-        qDebug()<<"connectToServer:tcp已有连接，正在断开...";
-    }
+    // 新的连接目标，之前的重连作废
+    m_host = host;
+    m_port = port;
+    m_wasConnected = false;
+    m_reconnecting = false;
+    m_reconnectTimer->stop();
 
-    // 尝试连接到服务器，并记录目标主机和端口
+    // 断开旧连接、建立新连接都在网络线程里进行
     qDebug() << "connectToServer:尝试连接到服务器：" << host << "端口：" << port;
+    QMetaObject::invokeMethod(m_worker, "connectToHost", Qt::QueuedConnection,
+                              Q_ARG(QString, host), Q_ARG(int, port));
 
-    socket->connectToHost(host, port);
-
-    // 检查连接状态，记录连接过程中的状态
-    if (socket->state() == QTcpSocket::ConnectingState) {
-        qDebug() << "connectToServer:连接中...";
-        // 启动连接超时定时器
-        if (timeoutTimer) {
-            timeoutTimer->start(timeoutDuration);
-        }
-    } else {
-        qDebug() << "connectToServer:socket 状态：未处于连接状态。";
+    // 启动连接超时定时器，连接成功或出错时停止
+    if (timeoutTimer) {
+        timeoutTimer->start(timeoutDuration);
     }
 }
 
@@ -117,10 +130,10 @@ void TcpClient::sendData(const QByteArray &data)
 
     // QMutexLocker locker(&m_mutex);
 
-    if (socket->state() == QTcpSocket::ConnectedState) {
+    if (isConnected()) {
         // 连接状态下，发送数据并记录发送的内容
         qDebug() << "sendData:发送数据到服务器：" << data;
-        socket->write(data);
+        write(data);
     } else {
         // 未连接到服务器时，记录错误信息
         qDebug() << "sendData:未连接到服务器，无法发送数据。";
@@ -134,7 +147,7 @@ void TcpClient::sendData(const QJsonObject &data){
 
 
     // 线程检查
-    if (!socket || !timeoutTimerSend) {
+    if (!m_worker || !timeoutTimerSend) {
         qWarning() << "TcpClient is being destroyed, cannot send data";
         return;
     }
@@ -146,15 +159,11 @@ void TcpClient::sendData(const QJsonObject &data){
     }
 
 
-    QJsonDocument doc(data);
-    QByteArray byteArray =doc.toJson(QJsonDocument::Compact);  // 使用 Compact 来避免格式化时添加不必要的空格
-
-    // 发送数据
-    if (socket && socket->isOpen()) {
-        qDebug() << "sendData(2):发送数据到服务器：" << QString(byteArray); // 输出时转换为 QString
-        socket->write(byteArray);
-        socket->flush();
-        qDebug() << "sendData(2):发送的数据: " << byteArray;
+    // 发送数据；重连期间先排队，断网时能用本地库的就用本地库
+    if (isConnected() || m_reconnecting) {
+        sendTracked(data);
+    } else if (showLocal(data)) {
+        timeoutTimerSend->stop();
     } else {
         qWarning() << "sendData(2):TCP连接未打开，无法发送数据";
     }
@@ -166,7 +175,7 @@ void TcpClient::sendData(const QString &command, const QJsonObject &data)
     QMutexLocker locker(&m_mutex);
 
     // 线程检查
-    if (!socket || !timeoutTimerSend) {
+    if (!m_worker || !timeoutTimerSend) {
         qWarning() << "TcpClient is being destroyed, cannot send data";
         return;
     }
@@ -185,19 +194,270 @@ void TcpClient::sendData(const QString &command, const QJsonObject &data)
     // jsonRequest["command"] = "echo";
     jsonRequest["data"] = data;
 
-    // 将 JSON 对象转换为 QByteArray
-    QJsonDocument doc(jsonRequest);
-    QByteArray byteArray =doc.toJson(QJsonDocument::Compact);  // 使用 Compact 来避免格式化时添加不必要的空格
+    // 发送数据；重连期间先排队，断网时能用本地库的就用本地库
+    if (isConnected() || m_reconnecting) {
+        sendTracked(jsonRequest);
+    } else if (showLocal(jsonRequest)) {
+        timeoutTimerSend->stop();
+    } else {
+        qWarning() << "sendData(2):TCP连接未打开，无法发送数据";
+    }
+}
+
+quint64 TcpClient::sendTracked(QJsonObject request)
+{
+    quint64 id = m_nextId++;
+    request["id"] = static_cast<qint64>(id);
+
+    // 回复交给发送时所处状态登记的窗口；超过超时时间还没回复就不再等
+    ReplyDispatcher::instance().track(id, StateManager::instance().currentState());
+    QTimer::singleShot(timeoutDuration, this, [this, id]() { forgetRequest(id); });
+
+    if (serveFromCache(id, request)) {
+        return id;
+    }
+    serveFromStore(id, request);
+    send(id, request);
+    return id;
+}
+
+bool TcpClient::serveFromCache(quint64 id, QJsonObject &request)
+{
+    const QString command = request["command"].toString();
+    if (ReplyCache::ttl(command) <= 0) {
+        return false;
+    }
+    const QJsonObject data = request["data"].toObject();
+
+    ReplyCache::Entry entry;
+    if (!ReplyCache::instance().lookup(command, data, entry)) {
+        request["version"] = QString();  // 请服务器给出内容版本
+        m_cacheable.insert(id, qMakePair(command, data));
+        return false;
+    }
+
+    if (ReplyCache::instance().isFresh(command, entry)) {
+        qDebug() << "serveFromCache:使用缓存回复：" << command;
+        timeoutTimerSend->stop();
+        QTimer::singleShot(0, this, [id, reply = entry.reply]() { ReplyDispatcher::instance().finish(id, reply); });
+        return true;
+    }
+
+    // 已过期：先用缓存渲染，同时向服务器验证；内容有变时再交给窗口一次
+    qDebug() << "serveFromCache:缓存已过期，先用缓存并后台验证：" << command;
+    quint64 cachedId = m_nextId++;
+    ReplyDispatcher::instance().track(cachedId, StateManager::instance().currentState());
+    QTimer::singleShot(0, this, [cachedId, reply = entry.reply]() { ReplyDispatcher::instance().finish(cachedId, reply); });
+
+    request["version"] = entry.version;
+    m_cacheable.insert(id, qMakePair(command, data));
+    return false;
+}
+
+bool TcpClient::updateCache(quint64 id, QJsonObject &reply)
+{
+    auto it = m_cacheable.find(id);
+    if (it == m_cacheable.end()) {
+        return true;
+    }
+    const QPair<QString, QJsonObject> query = it.value();
+    m_cacheable.erase(it);
+
+    const QString version = reply.take("version").toString();
+    const QString status = reply["reply"].toString();
+    if (status == "notModified") {
+        ReplyCache::instance().touch(query.first, query.second);
+        ReplyDispatcher::instance().cancel(id);  // 窗口已经显示了缓存的内容
+        return false;
+    }
+    if (status == "successful" && !version.isEmpty()) {
+        ReplyCache::instance().store(query.first, query.second, reply, version);
+    }
+    return true;
+}
+
+bool TcpClient::serveFromStore(quint64 id, QJsonObject &request)
+{
+    const QString kind = RecordStore::kindFor(request["command"].toString());
+    if (kind.isEmpty()) {
+        return false;
+    }
+    const bool shown = showLocal(request);
+    m_syncing.insert(id, qMakePair(kind, shown));
+    if (shown) {
+        QJsonObject data = request["data"].toObject();
+        data["since"] = RecordStore::instance().watermark(kind);
+        request["data"] = data;
+    }
+    return shown;
+}
+
+bool TcpClient::showLocal(const QJsonObject &request)
+{
+    const QString kind = RecordStore::kindFor(request["command"].toString());
+    if (kind.isEmpty()) {
+        return false;
+    }
+    const QJsonObject data = request["data"].toObject();
+    RecordStore &store = RecordStore::instance();
+    store.open(data["type"].toString(), data["username"].toString());
+    if (!store.hasSynced(kind)) {
+        return false;
+    }
+
+    qDebug() << "showLocal:使用本地库：" << kind;
+    quint64 localId = m_nextId++;
+    ReplyDispatcher::instance().track(localId, StateManager::instance().currentState());
+    QTimer::singleShot(0, this, [localId, reply = store.reply(kind)]() { ReplyDispatcher::instance().finish(localId, reply); });
+    return true;
+}
+
+bool TcpClient::mergeRecords(quint64 id, QJsonObject &reply)
+{
+    auto it = m_syncing.find(id);
+    if (it == m_syncing.end()) {
+        return true;
+    }
+    const QPair<QString, bool> sync = it.value();
+    m_syncing.erase(it);
+
+    // 同步失败时窗口继续显示本地库的内容
+    int changed = reply["reply"].toString() == "successful" ? RecordStore::instance().merge(sync.first, reply) : -1;
+    if (changed < 0) {
+        if (sync.second) {
+            ReplyDispatcher::instance().cancel(id);
+            return false;
+        }
+        return true;
+    }
+    if (changed == 0 && sync.second) {
+        ReplyDispatcher::instance().cancel(id);  // 没有改动，窗口已经显示了本地库的内容
+        return false;
+    }
+    reply = RecordStore::instance().reply(sync.first);
+    return true;
+}
+
+void TcpClient::send(quint64 id, const QJsonObject &request)
+{
+    const QString command = request["command"].toString();
+    remember(command, request);
+    ReplyCache::instance().invalidateFor(command);
 
-    // 发送数据
-    if (socket && socket->isOpen()) {
+    QByteArray byteArray = QJsonDocument(request).toJson(QJsonDocument::Compact);  // 使用 Compact 来避免格式化时添加不必要的空格
+    Outgoing outgoing{ command, byteArray + '\n', false };  // 服务器按换行切分请求
+    if (!m_reconnecting && isConnected()) {
         qDebug() << "sendData(2):发送数据到服务器：" << QString(byteArray); // 输出时转换为 QString
-        socket->write(byteArray);
-        socket->flush();
-        qDebug() << "sendData(2):发送的数据: " << byteArray;
+        write(outgoing.bytes);
+        outgoing.sent = true;
     } else {
-        qWarning() << "sendData(2):TCP连接未打开，无法发送数据";
+        qDebug() << "send:正在重连，请求排队：" << command;
+    }
+    m_outbox.insert(id, outgoing);
+}
+
+void TcpClient::remember(const QString &command, const QJsonObject &request)
+{
+    QJsonObject sticky = request;
+    sticky.remove("id");
+    if (command == "joinChat" || command == "subscribeNotice") {
+        m_sticky.insert(command, sticky);
+    } else if (command == "exitChat") {
+        m_sticky.remove("joinChat");
+    } else if (command == "subscribe") {
+        m_sticky.insert("subscribe:" + request["data"].toObject()["entity"].toString(), sticky);
+    } else if (command == "unsubscribe") {
+        const QString entity = request["data"].toObject()["entity"].toString();
+        for (auto it = m_sticky.begin(); it != m_sticky.end();) {
+            if (entity.isEmpty() ? it.key().startsWith("subscribe:") : it.key() == "subscribe:" + entity) {
+                it = m_sticky.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void TcpClient::forgetRequest(quint64 id)
+{
+    ReplyDispatcher::instance().cancel(id);
+    m_outbox.remove(id);
+    m_cacheable.remove(id);
+    m_syncing.remove(id);
+}
+
+// 重发不会改变服务器上的数据的请求：查询、订阅类和确认类
+bool TcpClient::isIdempotent(const QString &command)
+{
+    static const QStringList commands = { "ping", "echo", "resume", "subscribe", "unsubscribe", "subscribeNotice",
+                                          "ackNotice", "joinChat", "exitChat" };
+    return command.startsWith("query") || command.startsWith("search") || commands.contains(command);
+}
+
+void TcpClient::write(const QByteArray &data)
+{
+    QMetaObject::invokeMethod(m_worker, "write", Qt::QueuedConnection, Q_ARG(QByteArray, data));
+}
+
+bool TcpClient::isConnected() const
+{
+    return m_worker && m_worker->state() == QAbstractSocket::ConnectedState;
+}
+
+quint64 TcpClient::request(const QString &command, const QJsonObject &data, ReplyHandler handler,
+                           QObject *context, int timeout)
+{
+    QMutexLocker locker(&m_mutex);
+
+    quint64 id = m_nextId++;
+    ReplyDispatcher::instance().expect(id, context, std::move(handler));
+
+    // 每个请求各自计时，超时只结束这一个请求，不影响连接和其他请求
+    QTimer::singleShot(timeout > 0 ? timeout : timeoutDuration, this, [this, id]() {
+        m_outbox.remove(id);
+        ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "timeout" } });
+    });
+
+    if (!isConnected() && !m_reconnecting) {
+        qWarning() << "request:TCP连接未打开，无法发送请求" << command;
+        // 不在 request 内部直接回调，调用方拿到 id 之后才收到结果
+        QTimer::singleShot(0, this, [id]() {
+            ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "disconnected" } });
+        });
+        return id;
     }
+
+    QJsonObject jsonRequest;
+    jsonRequest["command"] = command;
+    jsonRequest["data"] = data;
+    jsonRequest["id"] = static_cast<qint64>(id);
+    send(id, jsonRequest);
+    return id;
+}
+
+void TcpClient::cancel(quint64 id)
+{
+    forgetRequest(id);
+}
+
+void TcpClient::setAutoReconnect(bool enabled)
+{
+    m_autoReconnect = enabled;
+}
+
+void TcpClient::setSessionToken(const QString &token)
+{
+    m_token = token;
+}
+
+bool TcpClient::isReconnecting() const
+{
+    return m_reconnecting;
+}
+
+int TcpClient::pendingRequests() const
+{
+    return ReplyDispatcher::instance().pending();
 }
 
 /*QByteArray TcpClient::receiveData()
@@ -263,67 +523,42 @@ void TcpClient::disconnectFromServer()
     // 断开与服务器的连接时记录日志
     qDebug() << "正在断开与服务器的连接...";
 
-    socket->disconnectFromHost();
+    // 主动断开不重连
+    m_wasConnected = false;
+    m_reconnecting = false;
+    m_reconnectTimer->stop();
+
+    QMetaObject::invokeMethod(m_worker, "disconnectFromHost", Qt::QueuedConnection);
 }
 
-void TcpClient::onReadyRead()
+void TcpClient::onDataArrived()
 {
-
-    // QMutexLocker locker(&m_mutex);
-
-    QByteArray data = socket->readAll();
-    qDebug() << "onReadyRead: 数据可以读取。";
-
-    // // 停止超时定时器
+    // 收到回复的第一段就停止超时计时，大回复分几段到达时不会误判超时
     stopTimeout();
-    qDebug()<<"onDataReceived:超时计数器已停止";
-
-
-    // 将 QByteArray 转换为 QJsonObject
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-
-    // 判断是否转换成功
-    if (doc.isObject()) {
-        QJsonObject jsonObject = doc.object();
-
-        QJsonObject dataObject;
-
-        QJsonObject jsonResponse = doc.object();
-
-        // 提取 "reply" 字段
-
-        QString replyStatus = jsonResponse["reply"].toString();
-        dataObject["reply"]=replyStatus;
-        qDebug() << "onReadyRead:服务器返回的状态: " << replyStatus;
-
-        // 提取 "data" 字段
-        if (jsonResponse.contains("data") && jsonResponse["data"].isObject()) {
-            QJsonObject data = jsonResponse["data"].toObject();
+}
 
-            // 遍历 "data" 中的每个 key-value 对，添加到 dataObject
-            QJsonObject::const_iterator it = data.constBegin();
-            while (it != data.constEnd()) {
-                dataObject[it.key()] = it.value();
-                qDebug() << "onReadyRead:添加到 dataObject: " << it.key() << " : " << it.value().toString();
-                qDebug()<<"2222222222222222222222222222222222"<<dataObject;
-                ++it;
-            }
-        } else {
-            qWarning() << "onReadyRead:没有找到 'data' 字段，或者 'data' 字段不是一个 JSON 对象";
+void TcpClient::onReplyDecoded(const QJsonObject &reply, bool hasId, quint64 id)
+{
+    qDebug() << "onReplyDecoded:服务器返回的状态: " << reply["reply"].toString();
+
+    // 带 id 的回复只交给发请求的一方，不带 id 的是服务器推送
+    if (hasId) {
+        m_outbox.remove(id);
+        QJsonObject result = reply;
+        if (updateCache(id, result) && mergeRecords(id, result)) {
+            ReplyDispatcher::instance().finish(id, result);
         }
+        return;
+    }
+    ReplyCache::instance().invalidateFor(reply["reply"].toString());
+    ReplyDispatcher::instance().push(reply);
 
-        // 打印data字段的内容
-        qDebug() << "onReadyRead:服务器返回的数据: " << dataObject<<"(判断传回的字节流是否成功解析为json)";
-
-        // 发射处理后的 QJsonObject
-        qDebug() << "onReadyRead:发射 dataReceivedJson 信号：" << dataObject;
-        emit dataReceivedJson(dataObject);
-        qDebug() << "onReadyRead:jsonObject:" << jsonObject;
+    emit dataReceivedJson(reply);
+}
 
-    } else {
-        // 如果转换失败，打印警告
-        qWarning() << "onReadyRead:接收到的数据无法转换为 QJsonObject：" << data;
-    }
+void TcpClient::onReplyTooLarge()
+{
+    emit errorOccurred("Reply too large.");
 }
 
 void TcpClient::onConnected()
@@ -337,6 +572,12 @@ void TcpClient::onConnected()
         timeoutTimer->stop();
     }
 
+    if (m_reconnecting) {
+        m_reconnectTimer->stop();
+        resumeSession();
+        return;
+    }
+    m_wasConnected = true;
 }
 
 void TcpClient::onDisconnected()
@@ -347,40 +588,179 @@ void TcpClient::onDisconnected()
     // 停止所有定时器
     stopTimeout();
 
+    // 意外断开：保留发件箱和订阅，重连后恢复
+    if (m_autoReconnect && (m_wasConnected || m_reconnecting)) {
+        startReconnect();
+        return;
+    }
+
+    // 连接断了，还在等回复的请求不会再有回复
+    m_outbox.clear();
+    ReplyDispatcher::instance().failAll("disconnected");
+
 }
 
-void TcpClient::onError(QAbstractSocket::SocketError socketError)
+void TcpClient::startReconnect()
 {
-    //详细的错误信息
-    qDebug() << "发生 socket 错误，错误字符串：" << socket->errorString();
+    if (!m_reconnecting) {
+        qDebug() << "startReconnect:连接意外断开，开始重连";
+        m_reconnecting = true;
+        m_attempt = 0;
+        m_reconnectTimer->start(0);  // 第一次立即重试，短暂断线能很快恢复
+    } else if (!m_reconnectTimer->isActive()) {
+        m_reconnectTimer->start(backoff(m_attempt));
+    }
+}
+
+void TcpClient::onReconnectTimer()
+{
+    if (m_attempt >= maxReconnectAttempts) {
+        qWarning() << "onReconnectTimer:重连" << m_attempt << "次均失败，放弃";
+        m_reconnecting = false;
+        m_wasConnected = false;
+        QMetaObject::invokeMethod(m_worker, "abort", Qt::QueuedConnection);
+        m_outbox.clear();
+        ReplyDispatcher::instance().failAll("disconnected");
+        emit errorOccurred("Reconnect failed.");
+        return;
+    }
+
+    ++m_attempt;
+    qDebug() << "onReconnectTimer:第" << m_attempt << "次重连" << m_host << m_port;
+    emit reconnecting(m_attempt);
+    QMetaObject::invokeMethod(m_worker, "connectToHost", Qt::QueuedConnection,
+                              Q_ARG(QString, m_host), Q_ARG(int, m_port));
+
+    // 到时还没连上就放弃这次尝试，开始下一次
+    m_reconnectTimer->start(backoff(m_attempt));
+}
+
+// 指数退避，取 [d/2, d] 之间的随机值，避免大量客户端在服务器重启后同时重连
+int TcpClient::backoff(int attempt) const
+{
+    int delay = qMin(reconnectBaseDelay << qMin(attempt, 16), reconnectMaxDelay);
+    return delay / 2 + QRandomGenerator::global()->bounded(delay / 2 + 1);
+}
+
+void TcpClient::resumeSession()
+{
+    if (m_token.isEmpty()) {
+        finishReconnect();
+        return;
+    }
 
-    // 具体的错误代码
-    qDebug() << "错误代码：" << socketError;
+    // 恢复会话的请求不进发件箱，直接发出；上一条连接上没等到回复的恢复请求作废
+    ReplyDispatcher::instance().cancel(m_resumeId);
+    quint64 id = m_nextId++;
+    m_resumeId = id;
+    ReplyDispatcher::instance().expect(id, this, [this](const QJsonObject &reply) {
+        const QString status = reply["reply"].toString();
+        if (status == "successful") {
+            finishReconnect();
+        } else if (status == "expired") {
+            qWarning() << "resumeSession:会话令牌已失效";
+            m_token.clear();
+            finishReconnect();
+            emit sessionExpired();
+        } else if (m_reconnecting && isConnected()) {
+            // 超时等情况：放弃这条连接，继续重连
+            QMetaObject::invokeMethod(m_worker, "abort", Qt::QueuedConnection);
+        }
+    });
+    QTimer::singleShot(timeoutDuration, this, [id]() {
+        ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "timeout" } });
+    });
+
+    QJsonObject request;
+    request["command"] = "resume";
+    request["data"] = QJsonObject{ { "token", m_token } };
+    request["id"] = static_cast<qint64>(id);
+    write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void TcpClient::finishReconnect()
+{
+    qDebug() << "finishReconnect:连接已恢复，重发请求" << m_outbox.size() << "条，订阅" << m_sticky.size() << "项";
+    m_reconnecting = false;
+    m_wasConnected = true;
+    m_attempt = 0;
+
+    // 先在新连接上重新登记订阅，回复无人关心
+    for (auto it = m_sticky.constBegin(); it != m_sticky.constEnd(); ++it) {
+        quint64 id = m_nextId++;
+        QJsonObject request = it.value();
+        request["id"] = static_cast<qint64>(id);
+        ReplyDispatcher::instance().expect(id, nullptr, [](const QJsonObject &) {});
+        QTimer::singleShot(timeoutDuration, this, [id]() { ReplyDispatcher::instance().cancel(id); });
+        write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+    }
+
+    // 再按原顺序重发：排队的请求都发，已发出的只重发幂等的
+    for (auto it = m_outbox.begin(); it != m_outbox.end();) {
+        const quint64 id = it.key();
+        if (!ReplyDispatcher::instance().isPending(id)) {
+            it = m_outbox.erase(it);  // 已超时或已取消
+        } else if (!it->sent || isIdempotent(it->command)) {
+            write(it->bytes);
+            it->sent = true;
+            ++it;
+        } else {
+            it = m_outbox.erase(it);
+            ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "disconnected" } });
+        }
+    }
+
+    emit reconnected();
+}
+
+void TcpClient::onError(const QString &error)
+{
+    //详细的错误信息
+    qDebug() << "发生 socket 错误，错误字符串：" << error;
 
     // 停止所有定时器
     stopTimeout();
 
+    // 会自动重连的错误不打扰用户，重连失败时再报错
+    if (m_autoReconnect && (m_wasConnected || m_reconnecting)) {
+        return;
+    }
+
     // 发出错误信号，通知外部
-    emit errorOccurred(socket->errorString());
+    emit errorOccurred(error);
 }
 
 void TcpClient::onTimeout()
 {
     // QMutexLocker locker(&m_mutex);
-    // 超时处理
-    QMessageBox::information(nullptr, "信息", "请求超时！");
+    QTimer* timer = qobject_cast<QTimer*>(sender());
+
+    // 重连期间的超时由重连流程处理
+    if (m_reconnecting) {
+        return;
+    }
+    // 已登录时请求超时多半是连接已失效：丢弃连接，断开后自动重连并重发
+    if (timer == timeoutTimerSend && m_autoReconnect && m_wasConnected && !m_token.isEmpty()) {
+        qDebug() << "onTimeout:请求超时，放弃当前连接并重连";
+        QMetaObject::invokeMethod(m_worker, "abort", Qt::QueuedConnection);
+        return;
+    }
+
+    // 超时处理：提示框不阻塞事件循环，关闭时自动释放
+    QMessageBox *box = new QMessageBox(QMessageBox::Information, "信息", "请求超时！");
+    box->setAttribute(Qt::WA_DeleteOnClose);
+    box->open();
 
     StateManager::instance().setState(WidgetState::Idle);
 
     // 确定是哪个定时器触发的超时
-    QTimer* timer = qobject_cast<QTimer*>(sender());
     if (timer) {
         timer->stop();
     }
 
     // 断开连接
-    if (socket && socket->state() != QAbstractSocket::UnconnectedState) {
-        socket->disconnectFromHost();
+    if (m_worker->state() != QAbstractSocket::UnconnectedState) {
+        disconnectFromServer();
     }
 
     emit loginTimeout();  // 触发超时信号
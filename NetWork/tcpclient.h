@@ -10,9 +10,17 @@
 #include<QTimer>
 #include<QMessageBox>
 #include <QMutexLocker>
+#include <QThread>
+#include <QMap>
 #include"../Instance/StateManager.h"
+#include"networker.h"
+#include"replydispatcher.h"
+#include"replycache.h"
+#include"recordstore.h"
 
 
+// 界面线程一侧的网络接口：socket 和回复解析在 NetWorker 的网络线程里，
+// 这里只负责发请求、计时和把解析好的回复交给 ReplyDispatcher
 class TcpClient : public QObject
 {
     Q_OBJECT
@@ -38,6 +46,27 @@ public:
     void setTimeout(int timeout);  // 设置超时时间
     void stopTimeout();  // 停止超时定时器
 
+    // 带请求 id 的请求：回复只交给 handler，不再经 dataReceivedJson 广播给所有窗口，
+    // 多个窗口可以同时各发各的请求。handler 收到的对象与 dataReceivedJson 的格式相同；
+    // 超时收到 {"reply":"timeout"}，连接断开收到 {"reply":"disconnected"}。
+    // context 被销毁后回复直接丢弃；timeout <= 0 时使用 setTimeout 设置的时间
+    using ReplyHandler = ReplyDispatcher::Handler;
+    quint64 request(const QString &command, const QJsonObject &data, ReplyHandler handler,
+                    QObject *context = nullptr, int timeout = 0);
+    void cancel(quint64 id);  // 取消后回复到达也不再调用 handler
+    int pendingRequests() const;
+
+    // 断线自动重连：连接意外断开后按带抖动的指数退避重试，连上后凭会话令牌恢复会话，
+    // 重新登记订阅，再重发断线时还没收到回复的只读请求和重连期间排队的请求；
+    // 已发出的写请求不重发，以 {"reply":"disconnected"} 结束。主动断开时不重连
+    void setAutoReconnect(bool enabled);
+    void setSessionToken(const QString &token);  // 登录成功后设置
+    bool isReconnecting() const;
+
+    static constexpr int reconnectBaseDelay = 200;    // 毫秒
+    static constexpr int reconnectMaxDelay = 10000;   // 毫秒
+    static constexpr int maxReconnectAttempts = 12;
+
 
 signals:
     void dataReceivedJson(const QJsonObject &jsonData); // 转换信号
@@ -47,17 +76,61 @@ signals:
 
     void loginTimeout();  // 超时信号
 
+    void reconnecting(int attempt);  // 开始第 attempt 次重连尝试
+    void reconnected();              // 会话已恢复，排队的请求已重发
+    void sessionExpired();           // 重连后会话令牌已失效，需要重新登录
+
 private slots:
-    void onReadyRead();
+    void onDataArrived();
+    void onReplyDecoded(const QJsonObject &reply, bool hasId, quint64 id);
+    void onReplyTooLarge();
     void onConnected();
     void onDisconnected();
-    void onError(QAbstractSocket::SocketError socketError);
+    void onError(const QString &error);
 
     void onTimeout();  // 超时处理槽
+    void onReconnectTimer();
 
 
 private:
 
+    // 给请求分配 id 并发送；sendData 发出的请求按发送时的 WidgetState 分发回复
+    quint64 sendTracked(QJsonObject request);
+
+    // 交给网络线程写出
+    void write(const QByteArray &data);
+    bool isConnected() const;
+
+    // 记入发件箱后发送；重连期间只排队，恢复会话后再发
+    void send(quint64 id, const QJsonObject &request);
+    void remember(const QString &command, const QJsonObject &request);  // 登记/注销需要重连后恢复的订阅
+    void forgetRequest(quint64 id);
+
+    // 可缓存的查询：有效期内直接用缓存回复，返回 true 表示不必发请求；
+    // 否则给请求带上缓存的版本号并记下，回复到达时更新缓存
+    bool serveFromCache(quint64 id, QJsonObject &request);
+    bool updateCache(quint64 id, QJsonObject &reply);  // 返回 false 表示回复不必再交给窗口
+
+    // 病历/医嘱列表：本地库同步过就先用它渲染，请求里带上水位，服务器只回之后改过的行；
+    // 回复到达时合并进本地库，有变化才把合并后的完整列表再交给窗口一次
+    bool serveFromStore(quint64 id, QJsonObject &request);
+    bool showLocal(const QJsonObject &request);  // 断网时直接用本地库回复，返回 false 表示本地库没有内容
+    bool mergeRecords(quint64 id, QJsonObject &reply);  // 返回 false 表示回复不必再交给窗口
+    static bool isIdempotent(const QString &command);
+
+    void startReconnect();
+    void resumeSession();
+    void finishReconnect();
+    int backoff(int attempt) const;
+
+    // 发件箱中的一条请求
+    struct Outgoing
+    {
+        QString command;
+        QByteArray bytes;  // 已带 id 和结尾的 '\n'
+        bool sent;
+    };
+
     // 私有构造函数（确保只能通过instance()创建）
     explicit TcpClient(QObject *parent = nullptr);
     ~TcpClient();
@@ -66,7 +139,25 @@ private:
     static TcpClient* m_instance;
 
 
-    QTcpSocket *socket;
+    QThread *m_thread;     // 网络线程
+    NetWorker *m_worker;   // 属于 m_thread，只能排队调用
+
+    quint64 m_nextId;  // 下一个请求 id
+
+    QMap<quint64, Outgoing> m_outbox;     // 还没收到回复的请求，按 id 即发送顺序排列
+    QMap<QString, QJsonObject> m_sticky;  // 连接级的订阅（聊天室、通知、变更订阅），重连后重新登记
+    QHash<quint64, QPair<QString, QJsonObject>> m_cacheable;  // 等待回复的可缓存查询：id -> (命令, 参数)
+    QHash<quint64, QPair<QString, bool>> m_syncing;  // 等待回复的增量同步：id -> (记录种类, 是否已用本地库渲染)
+
+    QString m_host;
+    int m_port;
+    QString m_token;         // 会话令牌
+    bool m_autoReconnect;
+    bool m_wasConnected;     // 连上过且没有主动断开，断开时应当重连
+    bool m_reconnecting;     // 正在重连或恢复会话，新请求只排队
+    int m_attempt;
+    quint64 m_resumeId;      // 当前这次恢复会话请求的 id
+    QTimer *m_reconnectTimer;
 
     QMutex m_mutex;
 
@@ -9,15 +9,18 @@ doctorNoticeClient::doctorNoticeClient(QWidget *parent)
     ui->setupUi(this);
 
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorNoticeClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitdie_7, this, &doctorNoticeClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &doctorNoticeClient::onErrorOccurred);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorNoticeClient::onDataReceivedNotice);
-    JsonMessageBuilder *builder = new JsonMessageBuilder("queryNoticeList");
-
-    StateManager::instance().setState(WidgetState::waitdie_9);
-
-    tcpClient->sendData(builder->build());
-
+    ReplyDispatcher::instance().routePush("notice", this, [this](const QJsonObject &data) { onDataReceivedNotice(data); });
+
+    // 登录后订阅一次：服务器先补推未确认的通知，之后有新通知直接推过来，不再轮询通知列表；
+    // 订阅由 TcpClient 记住，重连后自动恢复
+    JsonMessageBuilder *builder = new JsonMessageBuilder("subscribeNotice");
+    tcpClient->request("subscribeNotice", builder->build()["data"].toObject(), [](const QJsonObject &reply) {
+        if (reply["reply"].toString() != "successful") {
+            qDebug() << "doctorNoticeClient::订阅通知失败:" << reply["reply"].toString();
+        }
+    }, this);
     delete builder;
 }
 
@@ -33,15 +36,6 @@ doctorNoticeClient::~doctorNoticeClient()
 
 void doctorNoticeClient::onDataReceived(const QJsonObject &data){
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitdie_7) {
-        qDebug() << "patientinfo::onJudgeReceived:当前不是患者信息编辑判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     ui->listWidget->addItem(data["message"].toString());
 
 
@@ -60,6 +54,18 @@ void doctorNoticeClient::on_pushButton_clicked()
     delete builder;
 }
 
+void doctorNoticeClient::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+
+    JsonMessageBuilder *builder = new JsonMessageBuilder("joinChat");
+
+    StateManager::instance().setState(WidgetState::waitdie_7);
+
+    tcpClient->sendData(builder->build());
+    delete builder;
+}
+
 void doctorNoticeClient::closeEvent(QCloseEvent *event)
 {
     JsonMessageBuilder *builder = new JsonMessageBuilder("exitChat");
@@ -69,31 +75,34 @@ void doctorNoticeClient::closeEvent(QCloseEvent *event)
 }
 
 void doctorNoticeClient::onDataReceivedNotice(const QJsonObject &data){
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitdie_9) {
-        qDebug() << "patientinfo::onJudgeReceived:当前不是患者信息编辑判断接收状态，忽略接收到的数据";
-        return;
-    }
-
+    // 推送只带新通知，追加到列表末尾
     QList<DataManager::NoticeInfo> Notices=DataManager::instance().extractNotices(data);
 
-    for (const DataManager::NoticeInfo &Notice : Notices) {
+    qint64 shown = lastNoticeId;
+    for (int i = 0; i < Notices.size(); ++i) {
+        // 通知 id 不在 NoticeInfo 里，按相同的序号（notice_1、notice_2……）从推送中取
+        const qint64 id = data["notice_" + QString::number(i + 1)].toObject()["id"].toVariant().toLongLong();
+        if (id <= lastNoticeId) {
+            continue;
+        }
+        const DataManager::NoticeInfo &Notice = Notices[i];
         const QString each_instance=QString("[")+QString(Notice.type)
-        +QString("][：")+QString(Notice.username)+QString("]时间：")
-            +QString(Notice.time)+QString("::")+QString(Notice.message)
-            ;
+                                      +QString("][：")+QString(Notice.username)+QString("]时间：")
+                                      +QString(Notice.time)+QString("::")+QString(Notice.message)
+                                    ;
         ui->listWidget_2->addItem(each_instance);
+        shown = qMax(shown, id);
     }
+    if (shown == lastNoticeId) {
+        return;
+    }
+    lastNoticeId = shown;
 
-    JsonMessageBuilder *builder = new JsonMessageBuilder("joinChat");
-
-    StateManager::instance().setState(WidgetState::waitdie_7);
-
-    tcpClient->sendData(builder->build());
-    delete builder;
-};
+    // 确认已显示到的最大 id，服务器的已读游标随之前进，下次登录不再补推
+    QJsonObject ack;
+    ack["username"] = UserSession::instance().getValue("username");
+    ack["id"] = lastNoticeId;
+    tcpClient->request("ackNotice", ack, [](const QJsonObject &) {}, this);
+}
 
 
@@ -21,12 +21,14 @@ private slots:
     void on_pushButton_clicked();
 
 protected:
+    void showEvent(QShowEvent *event) override;   // 打开窗口时加入聊天
     void closeEvent(QCloseEvent *event) override; // 重写关闭事件
 
 
 private:
     Ui::patientNoticeClient *ui;
     TcpClient *tcpClient=TcpClient::instance();
+    qint64 lastNoticeId = 0;  // 已显示并确认的最大通知 id，重连后补推的旧通知据此跳过
 };
 
 #endif // PATIENTNOTICECLIENT_H
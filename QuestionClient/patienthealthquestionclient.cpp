@@ -9,7 +9,7 @@ patientHealthQuestionClient::patientHealthQuestionClient(QWidget *parent)
     ui->setupUi(this);
 
     tcpClient=TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &patientHealthQuestionClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientQuestionResult, this, &patientHealthQuestionClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &patientHealthQuestionClient::onErrorOccurred);
 }
 
@@ -40,13 +40,6 @@ void patientHealthQuestionClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitRecivePatientQuestionResult) {
-        qDebug() << "patientCaseMenuClient::onDataReceived:当前不是患者病例列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"patientHealthQuestionClient::onDataReceived:状态设置为Idle";
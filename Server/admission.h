@@ -0,0 +1,121 @@
+#pragma once
+
+// 准入控制: 按命令类别划分的隔舱(bulkhead), 每类各有并发上限和排队上限,
+// 外加一个按延迟自适应的全局并发上限(AIMD), 超限时直接回复 busy 而不是无限排队
+
+#include<string>
+#include<string_view>
+#include<mutex>
+#include<chrono>
+#include<algorithm>
+#include<condition_variable>
+
+enum command_class { cls_exempt = -1, cls_oltp = 0, cls_olap = 1, cls_count = 2 };
+
+// 交互类命令走 oltp, 全表扫描/大连接走 olap, 不访问数据库的命令不受限
+inline int classify_command(std::string_view command)
+{
+    if(command == "echo" || command == "ping" ||
+       command == "chat" || command == "joinChat" || command == "exitChat")
+        return cls_exempt;
+    if(command == "queryChart" || command == "queryPatientList" ||
+       command == "queryDoctorList" || command == "queryAttendance")
+        return cls_olap;
+    return cls_oltp;
+}
+
+struct bulkhead
+{
+    int limit, queue;
+    int running = 0, waiting = 0;
+};
+
+class admission
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    admission(int oltp_limit, int oltp_queue, int olap_limit, int olap_queue,
+              int min_limit, int max_limit, std::chrono::milliseconds max_wait)
+        : pool{ { oltp_limit, oltp_queue }, { olap_limit, olap_queue } },
+          limit(max_limit), min_limit(min_limit), max_limit(max_limit), max_wait(max_wait) { }
+
+    // 0 表示获得执行许可, 1 表示排队已满或等待超时, 应回复 busy
+    int acquire(int cls)
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        bulkhead &b = pool[cls];
+        if(runnable(cls)) return ++b.running, ++inflight, 0;
+        if(b.waiting >= b.queue) return ++shed, 1;
+        ++b.waiting;
+        bool ok = cv.wait_for(lock, max_wait, [&] { return runnable(cls); });
+        --b.waiting;
+        if(!ok) return ++shed, cv.notify_all(), 1;
+        return ++b.running, ++inflight, 0;
+    }
+    void release(int cls, clock::duration latency)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        --pool[cls].running, --inflight;
+        adapt(cls, std::chrono::duration<double, std::micro>(latency).count());
+        cv.notify_all();
+    }
+
+    int current_limit()
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        return int(limit);
+    }
+    long long shed_count()
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        return shed;
+    }
+
+private:
+    // 交互类优先: 只要还有 oltp 在排队, olap 就不能抢占空出来的名额
+    bool runnable(int cls) const
+    {
+        if(pool[cls].running >= pool[cls].limit || inflight >= int(limit)) return false;
+        return cls == cls_oltp || pool[cls_oltp].waiting == 0;
+    }
+    // 延迟明显高于本类观测到的最小延迟时乘性减小上限, 否则加性增大.
+    // 最小延迟按类别分开记: 登录这类毫秒级请求定下的基准不能拿来衡量报表查询
+    void adapt(int cls, double us)
+    {
+        double &min_rtt = this->min_rtt[cls];
+        if(min_rtt <= 0 || us < min_rtt) min_rtt = us;
+        else min_rtt += (us - min_rtt) * 0.001;
+        if(us > min_rtt * 2 + 1000) limit = std::max<double>(min_limit, limit * 0.9);
+        else limit = std::min<double>(max_limit, limit + 1.0 / limit);
+    }
+
+    std::mutex mu;
+    std::condition_variable cv;
+    bulkhead pool[cls_count];
+    int inflight = 0;
+    double limit, min_rtt[cls_count] = { };
+    int min_limit, max_limit;
+    std::chrono::milliseconds max_wait;
+    long long shed = 0;
+};
+
+// 作用域内持有执行许可, 析构时归还并把本次耗时反馈给自适应上限.
+// 耗时从获得许可时算起: 排队等待不算服务延迟, 否则排队越久上限收得越紧
+class admission_guard
+{
+public:
+    admission_guard(admission &a, int cls)
+        : a(a), cls(cls), ok(cls == cls_exempt || !a.acquire(cls)), start(admission::clock::now()) { }
+    ~admission_guard()
+    {
+        if(ok && cls != cls_exempt) a.release(cls, admission::clock::now() - start);
+    }
+    bool admitted() const { return ok; }
+
+private:
+    admission &a;
+    int cls;
+    bool ok;
+    admission::clock::time_point start;
+};
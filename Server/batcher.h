@@ -0,0 +1,80 @@
+#pragma once
+
+// 写后批量提交(group commit): 打卡/请假/问卷这类追加为主、集中爆发的写入先进队列,
+// 攒够 max_rows 行或最早一行等满 max_delay 后, 每张表合成一条多行 upsert, 各表分别提交.
+// 某张表的整批失败时逐行重试, 只有出错的那几行回复失败, 同一窗口里的其他行不受牵连
+
+#include<map>
+#include<mutex>
+#include<chrono>
+#include<future>
+#include<string>
+#include<vector>
+#include<functional>
+#include<condition_variable>
+
+class write_behind
+{
+public:
+    using clock = std::chrono::steady_clock;
+    // 在一个事务里依次执行给定语句, 全部成功返回 true
+    using runner = std::function<bool(const std::vector<std::string>&)>;
+
+    write_behind(int max_rows, std::chrono::milliseconds max_delay, runner run)
+        : max_rows(max_rows), max_delay(max_delay), run_transaction(std::move(run)) { }
+
+    // head 形如 "INSERT INTO `t` VALUES ", tail 为 ON DUPLICATE KEY UPDATE 子句, row 为 "(...)";
+    // 返回的 future 在这一行写入(或确定失败)后就绪
+    std::shared_future<bool> push(const std::string &table, const std::string &head,
+                                  const std::string &tail, std::string row)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        batch &b = pending[table];
+        if(b.rows.empty()) b.head = head, b.tail = tail;
+        if(!count++) first = clock::now();
+        b.rows.push_back(std::move(row));
+        b.done.emplace_back();
+        if(count == 1 || count >= max_rows) cv.notify_one();
+        return b.done.back().get_future().share();
+    }
+
+    void run()
+    {
+        for(;;)
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [this] { return count > 0; });
+            cv.wait_until(lock, first + max_delay, [this] { return count >= max_rows; });
+            std::map<std::string, batch> work;
+            work.swap(pending), count = 0;
+            lock.unlock();
+            for(auto &t : work) flush(t.second);
+        }
+    }
+
+private:
+    struct batch
+    {
+        std::string head, tail;
+        std::vector<std::string> rows;
+        std::vector<std::promise<bool>> done;  // 与 rows 一一对应
+    };
+
+    void flush(batch &b)
+    {
+        std::string s = b.head;
+        for(size_t i = 0; i < b.rows.size(); ++i) s += (i ? ", " : "") + b.rows[i];
+        bool ok = run_transaction({ s + b.tail });
+        for(size_t i = 0; i < b.rows.size(); ++i)
+            b.done[i].set_value(ok || (b.rows.size() > 1 && run_transaction({ b.head + b.rows[i] + b.tail })));
+    }
+
+    int max_rows;
+    std::chrono::milliseconds max_delay;
+    runner run_transaction;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::map<std::string, batch> pending;
+    int count = 0;
+    clock::time_point first;
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+// 多进程模式: 主进程 fork 出 N 个 worker, 各自以 SO_REUSEPORT 监听同一端口, 由内核把连接分摊到各个核上;
+// worker 之间用 Unix 数据报套接字组成本地总线, 聊天广播、缓存失效等事件经总线送达所有 worker.
+// 一条消息就是一个数据报, 大小受发送缓冲区限制; 装不下的消息只在本进程投递, 发布方可以改发能让对端自行重建的引用
+
+#include<map>
+#include<atomic>
+#include<string>
+#include<vector>
+#include<cerrno>
+#include<cstdlib>
+#include<exception>
+#include<algorithm>
+#include<iostream>
+#include<functional>
+#include<unistd.h>
+#include<sys/wait.h>
+#include<sys/socket.h>
+#include<boost/asio.hpp>
+
+using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+// 环境变量 SERVER_WORKERS 指定 worker 数, 缺省为 1 (单进程, 与原来行为一致)
+inline int worker_count()
+{
+    const char *s = std::getenv("SERVER_WORKERS");
+    int n = s ? std::atoi(s) : 1;
+    return n < 1 ? 1 : n;
+}
+
+inline void listen_on(boost::asio::ip::tcp::acceptor &acceptor, int port, bool shared)
+{
+    using boost::asio::ip::tcp;
+    tcp::endpoint endpoint(tcp::v4(), port);
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+    if(shared) acceptor.set_option(reuse_port(true));
+    acceptor.bind(endpoint);
+    acceptor.listen();
+}
+
+// 返回当前进程的 worker 编号; 主进程停在这里负责重新拉起退出的 worker, 不会返回
+inline int spawn_workers(int n)
+{
+    std::vector<pid_t> pid(n);
+    auto fork_worker = [&](int i)
+    {
+        pid_t p = fork();
+        if(p == 0) return true;
+        if(p < 0) std::cout << "fork failed: " << errno << '\n';
+        return pid[i] = p, false;
+    };
+    for(int i = 0; i < n; ++i) if(fork_worker(i)) return i;
+    for(;;)
+    {
+        int status;
+        pid_t p = wait(&status);
+        if(p < 0)
+        {
+            if(errno != EINTR) sleep(1);
+            continue;
+        }
+        for(int i = 0; i < n; ++i) if(pid[i] == p)
+        {
+            std::cout << "worker " << i << " (" << p << ") exited, restarting" << std::endl;
+            sleep(1);
+            if(fork_worker(i)) return i;
+        }
+    }
+}
+
+class bus
+{
+public:
+    using protocol = boost::asio::local::datagram_protocol;
+    using handler = std::function<void(const std::string&)>;
+    static constexpr size_t max_message = 1 << 20;
+
+    // 每个 worker 绑定 <prefix>.<index>, 发布时逐个发给其余 worker
+    void open(const std::string &prefix, int index, int count)
+    {
+        self = index;
+        for(int i = 0; i < count; ++i) peers.emplace_back(prefix + '.' + std::to_string(i));
+        if(count < 2) return;
+        io.notify_fork(boost::asio::io_context::fork_child);  // io 在 fork 之前就已构造
+        ::unlink(peers[index].path().c_str());
+        sock.open();
+        sock.bind(peers[index]);
+        boost::system::error_code ec;
+        sock.set_option(protocol::socket::send_buffer_size(max_message), ec);
+        sock.set_option(protocol::socket::receive_buffer_size(max_message), ec);
+        // 内核会把缓冲区截到系统上限, 并按两倍报告; 留一半给数据报本身的开销
+        protocol::socket::send_buffer_size actual;
+        sock.get_option(actual, ec);
+        if(!ec) limit = std::min<size_t>(max_message, actual.value() / 2);
+    }
+    // 只在启动阶段(run 之前)注册
+    void subscribe(const std::string &topic, handler h) { handlers[topic] = std::move(h); }
+
+    // 这条消息能否整条送到其余 worker
+    bool fits(const std::string &topic, const std::string &payload) const
+    {
+        return !sock.is_open() || topic.size() + 1 + payload.size() <= limit;
+    }
+    // 本进程同步投递, 其余 worker 异步收到; 对端暂时不在或接收队列已满(总线线程跟不上)时不等待, 直接丢弃并计数.
+    // 超过 limit 的消息不发给对端, 返回 false
+    bool publish(const std::string &topic, const std::string &payload)
+    {
+        deliver(topic, payload);
+        if(!sock.is_open()) return true;
+        if(!fits(topic, payload))
+        {
+            std::cout << "bus: " << topic << " message of " << payload.size() << " bytes not sent to peers\n";
+            return false;
+        }
+        std::string message = topic + '\n' + payload;
+        // 直接调 sendto: asio 的同步 send_to 遇到 EAGAIN 会等到可写, 一个卡住的 worker 会拖住所有发布方
+        for(int i = 0; i < int(peers.size()); ++i) if(i != self)
+        {
+            if(::sendto(sock.native_handle(), message.data(), message.size(), MSG_DONTWAIT,
+                        peers[i].data(), peers[i].size()) >= 0) continue;
+            if(errno != EAGAIN && errno != EWOULDBLOCK) continue;
+            long long n = ++dropped;
+            if(n == 1 || n % 1000 == 0) std::cout << "bus: worker " << i << " is behind, " << n << " messages dropped\n";
+        }
+        return true;
+    }
+    long long dropped_count() const { return dropped; }
+    void run()
+    {
+        if(!sock.is_open()) return;
+        std::vector<char> buf(1 << 16);
+        for(;;)
+        {
+            // 先看下一个数据报的实际长度, 缓冲区不够时放大, 不截断
+            ssize_t next = ::recv(sock.native_handle(), 0, 0, MSG_PEEK | MSG_TRUNC);
+            if(next < 0) continue;
+            if(size_t(next) > buf.size()) buf.resize(next);
+            boost::system::error_code ec;
+            size_t length = sock.receive(boost::asio::buffer(buf), 0, ec);
+            if(ec) continue;
+            std::string message(buf.data(), length);
+            size_t p = message.find('\n');
+            if(p == std::string::npos) continue;
+            deliver(message.substr(0, p), message.substr(p + 1));
+        }
+    }
+
+private:
+    // 处理函数抛出的异常(比如载荷不是合法 JSON)只丢掉这一条, 不让总线线程退出
+    void deliver(const std::string &topic, const std::string &payload)
+    {
+        auto it = handlers.find(topic);
+        if(it == handlers.end()) return;
+        try { it->second(payload); }
+        catch(const std::exception &e) { std::cout << "bus: " << topic << " handler failed: " << e.what() << '\n'; }
+    }
+
+    boost::asio::io_context io;
+    protocol::socket sock{ io };
+    std::vector<protocol::endpoint> peers;
+    std::map<std::string, handler> handlers;
+    std::atomic<long long> dropped{ 0 };
+    int self = 0;
+    size_t limit = max_message;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+// 患者目录: 用户名、姓名、姓名拼音首字母三种键放在一个有序集合里, 前缀查询即 lower_bound 后顺序扫描,
+// 供管理员/医生端输入联想使用, 不必每次把整张患者表发给客户端
+
+#include<set>
+#include<map>
+#include<mutex>
+#include<cctype>
+#include<string>
+#include<vector>
+#include<utility>
+#include<string_view>
+#include<shared_mutex>
+#include<iconv.h>
+
+// GB2312 一级汉字按拼音排序, 各声母的起始编码; 二级汉字按部首排序, 取不到首字母
+inline char gb2312_initial(unsigned code)
+{
+    static const unsigned start[] = { 0xb0a1, 0xb0c5, 0xb2c1, 0xb4ee, 0xb6ea, 0xb7a2, 0xb8c1, 0xb9fe, 0xbbf7,
+                                      0xbfa6, 0xc0ac, 0xc2e8, 0xc4c3, 0xc5b6, 0xc5be, 0xc6da, 0xc8bb, 0xc8f6,
+                                      0xcbfa, 0xcdda, 0xcef4, 0xd1b9, 0xd4d1, 0xd7fa };
+    static const char letter[] = "abcdefghjklmnopqrstwxyz";
+    if(code < start[0] || code >= start[23]) return 0;
+    int i = 0;
+    while(code >= start[i + 1]) ++i;
+    return letter[i];
+}
+
+// 姓名的拼音首字母, ASCII 字母数字原样(小写)保留, 其余字符跳过
+inline std::string pinyin_initials(std::string_view name)
+{
+    thread_local iconv_t cd = iconv_open("GB2312", "UTF-8");
+    std::string ret;
+    for(size_t i = 0; i < name.size();)
+    {
+        unsigned char c = name[i];
+        size_t n = c < 0x80 ? 1 : c >> 5 == 6 ? 2 : c >> 4 == 14 ? 3 : c >> 3 == 30 ? 4 : 1;
+        if(n == 1)
+        {
+            if(std::isalnum(c)) ret += std::tolower(c);
+            ++i;
+            continue;
+        }
+        char in[4], out[4];
+        std::string_view ch = name.substr(i, n);
+        ch.copy(in, ch.size()), i += n;
+        char *pin = in, *pout = out;
+        size_t left = ch.size(), room = sizeof out;
+        if(cd == iconv_t(-1) || iconv(cd, &pin, &left, &pout, &room) == size_t(-1) || pout - out != 2)
+        {
+            if(cd != iconv_t(-1)) iconv(cd, 0, 0, 0, 0);
+            continue;
+        }
+        if(char k = gb2312_initial((unsigned char)out[0] << 8 | (unsigned char)out[1])) ret += k;
+    }
+    return ret;
+}
+
+class patient_directory
+{
+public:
+    using entry = std::pair<std::string, std::string>;  // (username, name)
+
+    // 新增或改名, 同一用户名只保留最新的姓名
+    void put(const std::string &username, const std::string &name)
+    {
+        std::vector<std::string> k = keys(username, name);
+        std::unique_lock<std::shared_mutex> lock(mu);
+        auto it = names.find(username);
+        if(it != names.end())
+            for(auto &old : keys(username, it->second)) index.erase({ old, username });
+        names[username] = name;
+        for(auto &key : k) index.insert({ key, username });
+    }
+
+    // 按前缀(不区分大小写)匹配用户名、姓名或拼音首字母, 按键的字典序返回前 limit 个不同的患者
+    std::vector<entry> search(std::string_view prefix, size_t limit) const
+    {
+        std::string p;
+        for(unsigned char c : prefix) p += std::tolower(c);
+        std::vector<entry> ret;
+        std::set<std::string> seen;
+        std::shared_lock<std::shared_mutex> lock(mu);
+        for(auto it = index.lower_bound({ p, "" }); it != index.end() && ret.size() < limit; ++it)
+        {
+            if(it->first.compare(0, p.size(), p)) break;
+            if(seen.insert(it->second).second) ret.push_back({ it->second, names.at(it->second) });
+        }
+        return ret;
+    }
+
+    size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mu);
+        return names.size();
+    }
+
+private:
+    static std::vector<std::string> keys(const std::string &username, const std::string &name)
+    {
+        std::vector<std::string> ret{ username, name, pinyin_initials(name) };
+        for(auto &k : ret) for(auto &c : k) c = std::tolower((unsigned char)c);
+        return ret;
+    }
+
+    mutable std::shared_mutex mu;
+    std::set<std::pair<std::string, std::string>> index;  // (键, 用户名)
+    std::map<std::string, std::string> names;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+// 变更订阅: 连接按 (实体, 用户名) 订阅, 预约/病历/医嘱的某一行写入后, 推给患者或医生是该用户的订阅者,
+// 客户端据此局部更新列表, 不必每次改完再把整张表查一遍
+
+#include<set>
+#include<mutex>
+#include<string>
+#include<utility>
+#include<string_view>
+#include<boost/asio.hpp>
+
+class change_feed
+{
+public:
+    using socket_t = boost::asio::ip::tcp::socket;
+
+    void subscribe(socket_t *socket, std::string_view entity, std::string_view username)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        subs.insert({ socket, { std::string(entity), std::string(username) } });
+    }
+    // entity 为空时退订该连接的全部实体
+    void unsubscribe(socket_t *socket, std::string_view entity = "")
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        for(auto it = subs.lower_bound({ socket, { } }); it != subs.end() && it->first == socket;)
+            if(entity.empty() || it->second.first == entity) it = subs.erase(it);
+            else ++it;
+    }
+    // 对每个关心这一行的连接调用 f; 调用期间持有锁, f 只应记下连接, 写 socket 放到锁外
+    template<typename F>
+    void broadcast(std::string_view entity, std::string_view patient, std::string_view doctor, F f)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        socket_t *last = 0;
+        for(auto &s : subs)
+            if(s.first != last && s.second.first == entity && (s.second.second == patient || s.second.second == doctor))
+                f(last = s.first);
+    }
+
+private:
+    std::mutex mu;
+    std::set<std::pair<socket_t*, std::pair<std::string, std::string>>> subs;  // (连接, (实体, 用户名))
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+// 通知推送的订阅表: 每个订阅了通知的连接记下用户名、用户类型和已推送到的通知 id.
+// 离线期间的通知就留在 notice 表里, 用户确认收到的位置存成已读游标, 重新订阅时从游标之后补推
+
+#include<map>
+#include<mutex>
+#include<memory>
+#include<string>
+#include<vector>
+#include<string_view>
+#include<boost/asio.hpp>
+
+class notice_hub
+{
+public:
+    using socket_t = boost::asio::ip::tcp::socket;
+
+    struct subscriber
+    {
+        socket_t *socket;
+        std::string username, type;
+        long long pushed;  // 已推送的最大通知 id
+        std::mutex mu;     // 查库和入队期间持有, 同一连接的两次推送不会交错或重复
+    };
+
+    void subscribe(socket_t *socket, std::string_view username, std::string_view type, long long cursor)
+    {
+        auto s = std::make_shared<subscriber>();
+        s->socket = socket, s->username = username, s->type = type, s->pushed = cursor;
+        std::lock_guard<std::mutex> lock(mu);
+        subs[socket] = s;
+    }
+    void unsubscribe(socket_t *socket)
+    {
+        std::shared_ptr<subscriber> s;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            auto it = subs.find(socket);
+            if(it == subs.end()) return;
+            s = it->second, subs.erase(it);
+        }
+        std::lock_guard<std::mutex> wait(s->mu);  // 等进行中的推送结束, 之后不会再往这个连接入队
+        s->socket = 0;
+    }
+    std::shared_ptr<subscriber> find(socket_t *socket)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = subs.find(socket);
+        return it == subs.end() ? 0 : it->second;
+    }
+    // username 为空时返回全部订阅者(全员通知)
+    std::vector<std::shared_ptr<subscriber>> targets(std::string_view username)
+    {
+        std::vector<std::shared_ptr<subscriber>> ret;
+        std::lock_guard<std::mutex> lock(mu);
+        for(auto &s : subs) if(username.empty() || s.second->username == username) ret.push_back(s.second);
+        return ret;
+    }
+
+private:
+    std::mutex mu;
+    std::map<socket_t*, std::shared_ptr<subscriber>> subs;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+// 发送队列: 每个连接一个. 回复和推送都先进这个连接的队列, 同一时刻只有一个线程在写这个连接,
+// 帧不会交错. 连接线程自己的回复由它当场写出; 广播方(其他请求线程、总线线程)只入队,
+// 由写线程去写, 一个不读数据的客户端只会拖住一个写线程, 不会拖住广播方和后面的订阅者.
+// 队列积压超过上限的连接视为慢消费者: 丢弃积压的帧并 shutdown, 写线程和连接线程随即出错返回, 由连接线程清理
+
+#include<map>
+#include<mutex>
+#include<deque>
+#include<atomic>
+#include<memory>
+#include<string>
+#include<functional>
+#include<condition_variable>
+#include<boost/asio.hpp>
+
+class outbox
+{
+public:
+    using socket_t = boost::asio::ip::tcp::socket;
+    using writer = std::function<void(socket_t*, const std::string&)>;
+
+    struct peer
+    {
+        socket_t *socket;
+        std::mutex mu;        // 保护以下各项
+        std::mutex write_mu;  // 写 socket 期间持有, close 据此等进行中的写入结束
+        std::deque<std::string> queue;
+        size_t bytes = 0;     // queue 中的字节数
+        bool writing = false, scheduled = false, closed = false;
+    };
+
+    outbox(writer write, size_t limit) : write(std::move(write)), limit(limit) { }
+
+    void add(socket_t *socket)
+    {
+        auto p = std::make_shared<peer>();
+        p->socket = socket;
+        std::lock_guard<std::mutex> lock(mu);
+        peers[socket] = p;
+    }
+    // 连接线程释放 socket 之前调用; 返回后不会再有线程写这个 socket, 队列里没写出去的帧丢弃
+    void close(socket_t *socket)
+    {
+        std::shared_ptr<peer> p;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            auto it = peers.find(socket);
+            if(it == peers.end()) return;
+            p = it->second, peers.erase(it);
+        }
+        {
+            std::lock_guard<std::mutex> lock(p->mu);
+            p->closed = true, p->queue.clear(), p->bytes = 0;
+        }
+        std::lock_guard<std::mutex> wait(p->write_mu);
+    }
+    std::shared_ptr<peer> find(socket_t *socket)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = peers.find(socket);
+        return it == peers.end() ? nullptr : it->second;
+    }
+
+    // 只入队, 可以在持有其他锁时调用; 之后要在锁外 schedule 或 drain.
+    // 积压超过上限时丢弃整个队列并 shutdown, 正阻塞在这个连接上的写入随即出错返回
+    void post(peer &p, std::string frame)
+    {
+        std::lock_guard<std::mutex> lock(p.mu);
+        if(p.closed) return;
+        p.bytes += frame.size(), p.queue.push_back(std::move(frame));
+        if(p.bytes <= limit) return;
+        boost::system::error_code ec;
+        p.socket->shutdown(socket_t::shutdown_both, ec);
+        p.closed = true, p.queue.clear(), p.bytes = 0, ++dropped;
+    }
+    // 交给写线程去写; 已经有线程在写或已在等写线程时什么也不做
+    void schedule(const std::shared_ptr<peer> &p)
+    {
+        {
+            std::lock_guard<std::mutex> lock(p->mu);
+            if(p->writing || p->scheduled || p->closed || p->queue.empty()) return;
+            p->scheduled = true;
+        }
+        std::lock_guard<std::mutex> lock(ready_mu);
+        ready.push_back(p);
+        ready_cv.notify_one();
+    }
+    // 由当前线程把队列写完(包括写的过程中别人新入队的帧); 已经有线程在写时直接返回
+    void drain(peer &p)
+    {
+        {
+            std::lock_guard<std::mutex> lock(p.mu);
+            if(p.writing || p.closed || p.queue.empty()) return;
+            p.writing = true;
+        }
+        std::lock_guard<std::mutex> guard(p.write_mu);
+        for(std::deque<std::string> batch;; batch.clear())
+        {
+            {
+                std::lock_guard<std::mutex> lock(p.mu);
+                if(p.closed || p.queue.empty())
+                {
+                    p.writing = false;
+                    return;
+                }
+                batch.swap(p.queue), p.bytes = 0;
+            }
+            for(auto &frame : batch) write(p.socket, frame);
+        }
+    }
+    // 连接线程回复自己的请求
+    void send(socket_t *socket, std::string frame)
+    {
+        if(auto p = find(socket)) post(*p, std::move(frame)), drain(*p);
+    }
+    // 推送给其他连接: 只入队, 不在调用方线程里写
+    void push(const std::shared_ptr<peer> &p, std::string frame)
+    {
+        post(*p, std::move(frame)), schedule(p);
+    }
+
+    // 写线程: 取出待写的连接写到队列为空, 可以开多个
+    void run()
+    {
+        for(;;)
+        {
+            std::shared_ptr<peer> p;
+            {
+                std::unique_lock<std::mutex> lock(ready_mu);
+                ready_cv.wait(lock, [this] { return !ready.empty(); });
+                p = std::move(ready.front()), ready.pop_front();
+            }
+            {
+                std::lock_guard<std::mutex> lock(p->mu);
+                p->scheduled = false;
+            }
+            drain(*p);
+        }
+    }
+
+    long long dropped_count() const { return dropped; }
+
+private:
+    writer write;
+    size_t limit;
+    std::mutex mu;
+    std::map<socket_t*, std::shared_ptr<peer>> peers;
+    std::mutex ready_mu;
+    std::condition_variable ready_cv;
+    std::deque<std::shared_ptr<peer>> ready;
+    std::atomic<long long> dropped{ 0 };
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+// 空闲连接回收: 每个连接有读截止时间(两次请求之间的最长空闲)和写截止时间(单次回复的最长阻塞),
+// 用时间轮按秒推进, 每个 tick 只检查当前槽里的连接; 截止时间被顺延的连接惰性地挂到新槽里.
+// 超时的连接直接 shutdown, 阻塞在 read_some/write 上的线程随即出错返回并自行清理.
+
+#include<vector>
+#include<mutex>
+#include<atomic>
+#include<thread>
+#include<memory>
+#include<chrono>
+#include<functional>
+#include<unordered_map>
+#include<boost/asio.hpp>
+
+class reaper
+{
+public:
+    using socket_t = boost::asio::ip::tcp::socket;
+
+    reaper(int idle_seconds, int write_seconds, int slots, std::function<void(socket_t*)> on_reap)
+        : idle(idle_seconds), write(write_seconds), wheel(slots),
+          start(std::chrono::steady_clock::now()), on_reap(std::move(on_reap)) { }
+
+    void add(socket_t *socket)
+    {
+        auto s = std::make_shared<session>();
+        s->socket = socket, s->read_deadline = now() + idle;
+        std::lock_guard<std::mutex> lock(mu);
+        sessions[socket] = s;
+        schedule(s, s->read_deadline);
+    }
+    // 连接线程退出前调用, 之后时间轮不会再碰这个 socket
+    void remove(socket_t *socket)
+    {
+        std::shared_ptr<session> s = find(socket);
+        if(!s) return;
+        std::lock_guard<std::mutex> guard(s->mu);
+        s->closed = true;
+        std::lock_guard<std::mutex> lock(mu);
+        sessions.erase(socket);
+    }
+    // 收到一个完整请求, 顺延读截止时间
+    void touch(socket_t *socket)
+    {
+        if(auto s = find(socket)) s->read_deadline = now() + idle;
+    }
+    // 写截止时间可能早于当前所在的槽, 需要提前挂一次; 旧槽里的那份到时按过期条目丢弃
+    void begin_write(socket_t *socket)
+    {
+        auto s = find(socket);
+        if(!s) return;
+        long long d = now() + write;
+        s->write_deadline = d;
+        std::lock_guard<std::mutex> lock(mu);
+        if(d < s->slot_at) schedule(s, d);
+    }
+    void end_write(socket_t *socket)
+    {
+        if(auto s = find(socket)) s->write_deadline = 0;
+    }
+
+    // 推进一个 tick, 处理当前槽; 由独立线程每秒调用一次
+    void tick()
+    {
+        std::vector<std::shared_ptr<session>> due;
+        long long t = now();
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            for(; cursor <= t; ++cursor)
+            {
+                auto &slot = wheel[cursor % wheel.size()];
+                for(auto &s : slot) if(s->slot_at == cursor) due.push_back(s);
+                slot.clear();
+            }
+        }
+        for(auto &s : due)
+        {
+            if(s->closed) continue;
+            long long d = deadline(*s);
+            if(d > t)
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                schedule(s, d);
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> guard(s->mu);
+                if(s->closed) continue;
+                boost::system::error_code ec;
+                s->socket->shutdown(socket_t::shutdown_both, ec);
+                on_reap(s->socket);
+            }
+            ++reaped;
+        }
+    }
+    void run()
+    {
+        for(;;) std::this_thread::sleep_for(std::chrono::seconds(1)), tick();
+    }
+
+    long long reaped_count() const { return reaped; }
+
+private:
+    struct session
+    {
+        socket_t *socket;
+        std::mutex mu;
+        std::atomic<long long> read_deadline{ 0 }, write_deadline{ 0 };
+        std::atomic<bool> closed{ false };
+        long long slot_at = 0;
+    };
+
+    long long now() const
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+    static long long deadline(const session &s)
+    {
+        long long r = s.read_deadline, w = s.write_deadline;
+        return w && w < r ? w : r;
+    }
+    // 超出轮子跨度的截止时间先挂在最远的槽上, 到时再重新挂
+    void schedule(const std::shared_ptr<session> &s, long long d)
+    {
+        long long last = cursor + (long long)wheel.size() - 1;
+        if(d < cursor) d = cursor;
+        if(d > last) d = last;
+        s->slot_at = d;
+        wheel[d % wheel.size()].push_back(s);
+    }
+    std::shared_ptr<session> find(socket_t *socket)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = sessions.find(socket);
+        return it == sessions.end() ? nullptr : it->second;
+    }
+
+    int idle, write;
+    std::mutex mu;
+    std::vector<std::vector<std::shared_ptr<session>>> wheel;
+    std::unordered_map<socket_t*, std::shared_ptr<session>> sessions;
+    long long cursor = 0;
+    std::chrono::steady_clock::time_point start;
+    std::function<void(socket_t*)> on_reap;
+    std::atomic<long long> reaped{ 0 };
+};
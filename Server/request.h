@@ -0,0 +1,47 @@
+#pragma once
+
+// 处理函数读取请求字段的接口: 请求解析一次后只以 const 引用传递,
+// 对象字段取指针, 字符串字段取 string_view, 都直接指向解析结果, 不复制请求内容
+
+#include<string>
+#include<string_view>
+#include<nlohmann/json.hpp>
+#include"schema.h"
+
+// 返回 0 成功, 1 字段缺失, 2 类型不符
+inline int get_json(const nlohmann::json *&v, const nlohmann::json &k, const char *s)
+{
+    auto it = k.find(s);
+    if(it == k.end()) return 1;
+    return v = &*it, 0;
+}
+inline int get_json(std::string_view &v, const nlohmann::json &k, const char *s)
+{
+    const nlohmann::json *p;
+    if(get_json(p, k, s)) return 1;
+    if(!p->is_string()) return 2;
+    return v = p->get_ref<const std::string&>(), 0;
+}
+// 整数, 或内容为整数的字符串
+inline int get_json(long long &v, const nlohmann::json &k, const char *s)
+{
+    const nlohmann::json *p;
+    if(get_json(p, k, s)) return 1;
+    if(p->is_number_integer()) return v = p->get<long long>(), 0;
+    if(!p->is_string() || !parse_int(p->get_ref<const std::string&>(), v)) return 2;
+    return 0;
+}
+inline std::string field_error(int code, const char *s)
+{
+    return (code == 1 ? "no [" : "bad [") + std::string(s) + ']';
+}
+// 一帧请求解析成 JSON: 返回 0 成功, 1 空帧, 2 格式错误.
+// 字符串里的空格原样保留(如 watermark "2026-10-19 07:13:13.123"), 字符串外的空白由 json::parse 跳过
+inline int parse_frame(std::string_view frame, nlohmann::json &j)
+{
+    if(frame.find_first_not_of(" \t\r\n") == frame.npos) return 1;
+    j = nlohmann::json::parse(frame, nullptr, false);
+    return j.is_discarded() ? 2 : 0;
+}
+// 同步水位: 空串, 或 MySQL DATETIME 文本(如 "2026-10-19 07:13:13.123")
+inline bool is_watermark(std::string_view s) { return s.find_first_not_of("0123456789-:. ") == s.npos; }
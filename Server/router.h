@@ -0,0 +1,182 @@
+#pragma once
+
+// 读写分离: 写语句(insert_sql 等)固定走主库连接池, 读语句轮询分发到各只读副本的连接池;
+// 同一连接(即同一处理线程)写入后的一段时间内读也走主库, 保证读到自己刚写的数据.
+// 连接由驱动 D 建立和关闭(服务器用 MySQL C API), 测试时换成不连数据库的替身:
+//   D::handle; static handle D::connect(endpoint, user, password, name, error), 失败返回空; static void D::close(handle)
+
+#include<mutex>
+#include<atomic>
+#include<chrono>
+#include<memory>
+#include<string>
+#include<vector>
+#include<cstdlib>
+#include<condition_variable>
+
+struct db_endpoint
+{
+    std::string host;
+    int port;
+};
+
+inline int env_int(const char *key, int fallback)
+{
+    const char *s = std::getenv(key);
+    return s && *s ? std::atoi(s) : fallback;
+}
+
+// "host:port,host:port", 端口缺省为 3306
+inline std::vector<db_endpoint> parse_endpoints(const char *s)
+{
+    std::vector<db_endpoint> ret;
+    std::string list = s ? s : "", item;
+    for(size_t b = 0, e; b < list.size(); b = e + 1)
+    {
+        e = list.find(',', b);
+        if(e == std::string::npos) e = list.size();
+        item = list.substr(b, e - b);
+        if(item.empty()) continue;
+        size_t c = item.find(':');
+        if(c == std::string::npos) ret.push_back({ item, 3306 });
+        else ret.push_back({ item.substr(0, c), std::atoi(item.c_str() + c + 1) });
+    }
+    return ret;
+}
+
+// SELECT/SHOW 之外的语句都按写处理
+inline bool is_write_sql(const std::string &sql)
+{
+    size_t p = sql.find_first_not_of(" \t\r\n(");
+    if(p == std::string::npos) return true;
+    auto starts = [&](const char *k)
+    {
+        for(size_t i = 0; k[i]; ++i)
+            if(p + i >= sql.size() || (sql[p + i] | 32) != k[i]) return false;
+        return true;
+    };
+    return !starts("select") && !starts("show");
+}
+
+template<class D>
+class basic_db_pool
+{
+public:
+    using handle = typename D::handle;
+
+    ~basic_db_pool() { for(auto c : idle) D::close(c); }
+
+    // 至少建立一条连接才算成功
+    bool open(const db_endpoint &e, const char *user, const char *password,
+              const char *name, int size, std::string &error)
+    {
+        for(int i = 0; i < size; ++i)
+        {
+            handle c = D::connect(e, user, password, name, error);
+            if(!c) break;
+            idle.push_back(c);
+        }
+        return !idle.empty();
+    }
+    handle acquire()
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        cv.wait(lock, [this] { return !idle.empty(); });
+        handle c = idle.back();
+        return idle.pop_back(), c;
+    }
+    void release(handle c)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        idle.push_back(c), cv.notify_one();
+    }
+
+private:
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<handle> idle;
+};
+
+template<class D>
+class basic_db_router
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using pool = basic_db_pool<D>;
+    using handle = typename D::handle;
+
+    // 借出的连接, 析构时归还所属连接池
+    class lease
+    {
+    public:
+        lease(pool *from, bool replica) : from(from), conn(from->acquire()), from_replica(replica) { }
+        lease(lease &&o) noexcept : from(o.from), conn(o.conn), from_replica(o.from_replica) { o.conn = 0; }
+        lease &operator=(lease &&o) noexcept
+        {
+            if(this != &o)
+            {
+                if(conn) from->release(conn);
+                from = o.from, conn = o.conn, from_replica = o.from_replica, o.conn = 0;
+            }
+            return *this;
+        }
+        ~lease() { if(conn) from->release(conn); }
+        operator handle() const { return conn; }
+        bool replica() const { return from_replica; }
+
+    private:
+        pool *from;
+        handle conn;
+        bool from_replica;
+    };
+
+    explicit basic_db_router(std::chrono::milliseconds sticky) : sticky(sticky) { }
+
+    // 主库必须可用; 连不上的副本跳过, 没有可用副本时读也走主库
+    bool open(const db_endpoint &primary_endpoint, const std::vector<db_endpoint> &replica_endpoints,
+              const char *user, const char *password, const char *name, int size, std::string &error)
+    {
+        if(!primary_pool.open(primary_endpoint, user, password, name, size, error)) return false;
+        for(auto &e : replica_endpoints)
+        {
+            auto p = std::make_unique<pool>();
+            std::string ignored;
+            if(p->open(e, user, password, name, size, ignored)) replicas.push_back(std::move(p));
+        }
+        return true;
+    }
+
+    lease route(bool write)
+    {
+        if(write) return mark_write(), primary();
+        if(replicas.empty() || clock::now() - last_write() < sticky) return primary();
+        return lease(replicas[next++ % replicas.size()].get(), true);
+    }
+    lease primary() { return lease(&primary_pool, false); }
+    // 在 route 选出的连接上执行 query(连接), query 返回是否成功; 在副本上失败(如副本宕机)时改到主库再执行一次.
+    // 返回执行所用的连接, 调用方接着在上面取结果
+    template<class F>
+    lease execute(bool write, F &&query, bool &ok)
+    {
+        lease conn = route(write);
+        ok = query(handle(conn));
+        if(!ok && conn.replica()) conn = primary(), ok = query(handle(conn));
+        return conn;
+    }
+    // 写入不经 route 直接提交时(如批量写), 由发起请求的线程登记一次写
+    void mark_write() { last_write() = clock::now(); }
+    size_t replica_count() const { return replicas.size(); }
+
+private:
+    // 每个连接由独立线程处理, 线程局部变量即是该会话最近一次写入的时间
+    static clock::time_point &last_write()
+    {
+        static thread_local clock::time_point t;
+        return t;
+    }
+
+    pool primary_pool;
+    std::vector<std::unique_ptr<pool>> replicas;
+    std::atomic<size_t> next{ 0 };
+    clock::duration sticky;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+// 号源: 每个 (医生, 日期) 一项, 放在 fork 之前映射的共享内存里, 所有 worker 看到同一份计数;
+// 预约时对已约人数做比较并自增(CAS), 不到上限才放行, 再在当天的时段位图上原子地占住所选时段,
+// 整个检查不经过数据库, 也不加锁
+
+#include<map>
+#include<mutex>
+#include<atomic>
+#include<cstdint>
+#include<string>
+#include<cstring>
+#include<string_view>
+#include<shared_mutex>
+#include<functional>
+#include<sys/mman.h>
+
+class day_table
+{
+public:
+    static constexpr int slot_seconds = 15 * 60, slots_per_day = 24 * 3600 / slot_seconds;
+
+    struct day
+    {
+        std::atomic<int> state;  // 0 空, 1 正在写入键, 2 可用
+        int date;                // yyyymmdd
+        char doctor[52];
+        std::atomic<int> booked;
+        std::atomic<uint64_t> taken[(slots_per_day + 63) / 64];  // 第 i 位为 1 表示第 i 个时段已约
+    };
+    static_assert(std::atomic<int>::is_always_lock_free, "shared counters need lock-free atomics");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared bitmaps need lock-free atomics");
+
+    // capacity 取 2 的幂; 匿名共享映射会被 fork 出的 worker 继承
+    explicit day_table(size_t capacity) : mask(capacity - 1)
+    {
+        void *p = mmap(0, capacity * sizeof(day), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        slot = p == MAP_FAILED ? 0 : static_cast<day*>(p);  // 映射得到的页已清零, 即全部为空
+    }
+
+    // 找 (doctor, date) 对应的项, create 时不存在则新建(created 置 true);
+    // 日期早于 today 的项可被新键原地复用, 表满或未映射成功时返回 nullptr
+    day *find(std::string_view doctor, int date, int today, bool create, bool *created = 0)
+    {
+        if(!slot || doctor.size() >= sizeof(day::doctor)) return 0;
+        size_t home = std::hash<std::string_view>()(doctor) * 31 + date;
+        // 第一遍只查找, 直到遇到空位; 避免在已有该键的情况下又占用前面一个可复用的位置
+        for(size_t i = 0; i <= mask; ++i)
+        {
+            day &d = slot[(home + i) & mask];
+            int s = wait_ready(d);
+            if(s == 0) break;
+            if(same(d, doctor, date)) return &d;
+        }
+        if(!create) return 0;
+        for(size_t i = 0; i <= mask; ++i)
+        {
+            day &d = slot[(home + i) & mask];
+            int s = wait_ready(d);
+            if(s == 2 && same(d, doctor, date)) return &d;
+            if(s == 2 && d.date >= today) continue;
+            if(!d.state.compare_exchange_strong(s, 1))
+            {
+                --i;  // 被别的 worker 抢先, 重新看这一格
+                continue;
+            }
+            d.date = date, std::memset(d.doctor, 0, sizeof d.doctor), doctor.copy(d.doctor, doctor.size());
+            d.booked.store(0);
+            for(auto &w : d.taken) w.store(0);
+            d.state.store(2);
+            if(created) *created = true;
+            return &d;
+        }
+        return 0;
+    }
+
+    // 已约人数小于 limit 时加一并返回 true
+    static bool try_book(day &d, int limit)
+    {
+        int n = d.booked.load();
+        while(n < limit) if(d.booked.compare_exchange_weak(n, n + 1)) return true;
+        return false;
+    }
+    static void cancel(day &d)
+    {
+        int n = d.booked.load();
+        while(n > 0 && !d.booked.compare_exchange_weak(n, n - 1));
+    }
+
+    // 原子地占住第 slot 个时段, 已被占用时返回 false
+    static bool reserve(day &d, int slot)
+    {
+        uint64_t bit = uint64_t(1) << slot % 64;
+        return !(d.taken[slot / 64].fetch_or(bit) & bit);
+    }
+    static void release(day &d, int slot)
+    {
+        d.taken[slot / 64].fetch_and(~(uint64_t(1) << slot % 64));
+    }
+    static bool is_taken(const day &d, int slot)
+    {
+        return d.taken[slot / 64].load() >> slot % 64 & 1;
+    }
+
+private:
+    static int wait_ready(day &d)
+    {
+        int s;
+        while((s = d.state.load()) == 1);
+        return s;
+    }
+    static bool same(const day &d, std::string_view doctor, int date)
+    {
+        return d.date == date && doctor == d.doctor;
+    }
+
+    day *slot;
+    size_t mask;
+};
+
+// 各医生的每日号源上限和出诊时间(当天秒数, [begin, end)), 启动时从 doctorInfo 载入, 修改医生信息时经总线更新
+struct doctor_rule
+{
+    int limit, begin, end;
+};
+
+class doctor_rules
+{
+public:
+    void put(const std::string &doctor, doctor_rule rule)
+    {
+        std::unique_lock<std::shared_mutex> lock(mu);
+        rules[doctor] = rule;
+    }
+    bool get(std::string_view doctor, doctor_rule &rule) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mu);
+        auto it = rules.find(doctor);
+        if(it == rules.end()) return false;
+        return rule = it->second, true;
+    }
+
+private:
+    mutable std::shared_mutex mu;
+    std::map<std::string, doctor_rule, std::less<>> rules;
+};
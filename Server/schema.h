@@ -0,0 +1,293 @@
+#pragma once
+
+// 表结构的编译期描述: 每张表一个 constexpr schema, 列带类型(文本/整数/定点数/日期/时间).
+// 由它生成 SQL 模板、查询结果行解码和 JSON 编码; 列名写错或按错误类型取值都在编译期报错.
+// 线上协议不变: JSON 里的字段仍然全是字符串, 时间列按客户端约定输出整点小时数.
+
+#include<string>
+#include<vector>
+#include<cstdlib>
+#include<string_view>
+#include<type_traits>
+#include<nlohmann/json.hpp>
+
+enum col_type { t_text, t_int, t_decimal, t_date, t_time };
+
+struct column
+{
+    const char *name;
+    col_type type;
+};
+
+constexpr bool same_name(const char *a, const char *b)
+{
+    return *a == *b && (!*a || same_name(a + 1, b + 1));
+}
+
+template<size_t N>
+struct schema
+{
+    const char *name;
+    column col[N];
+
+    static constexpr int size() { return N; }
+    // 用在常量表达式里时, 不存在的列名会让编译失败
+    constexpr int index(const char *c) const
+    {
+        for(size_t i = 0; i < N; ++i) if(same_name(col[i].name, c)) return i;
+        throw "no such column";
+    }
+};
+
+constexpr schema<3> s_account{ "account",
+    { { "username", t_text }, { "type", t_text }, { "reverse", t_text } } };
+constexpr schema<7> s_patientInfo{ "patientInfo",
+    { { "username", t_text }, { "name", t_text }, { "gender", t_text }, { "birthday", t_date },
+      { "id", t_text }, { "phoneNumber", t_text }, { "email", t_text } } };
+constexpr schema<8> s_doctorInfo{ "doctorInfo",
+    { { "username", t_text }, { "name", t_text }, { "id", t_text }, { "department", t_text },
+      { "cost", t_decimal }, { "begin", t_time }, { "end", t_time }, { "limit", t_int } } };
+constexpr schema<2> s_namelist{ "account",
+    { { "username", t_text }, { "name", t_text } } };
+constexpr schema<6> s_appointment{ "appointment",
+    { { "patientUsername", t_text }, { "doctorUsername", t_text }, { "date", t_date },
+      { "time", t_time }, { "cost", t_decimal }, { "status", t_text } } };
+constexpr schema<9> s_case{ "case",
+    { { "patientUsername", t_text }, { "doctorUsername", t_text }, { "date", t_date },
+      { "time", t_time }, { "main", t_text }, { "now", t_text }, { "past", t_text },
+      { "check", t_text }, { "diagnose", t_text } } };
+constexpr schema<8> s_advice{ "advice",
+    { { "patientUsername", t_text }, { "doctorUsername", t_text }, { "date", t_date },
+      { "time", t_time }, { "medicine", t_text }, { "check", t_text }, { "therapy", t_text },
+      { "care", t_text } } };
+constexpr schema<4> s_notice{ "notice",
+    { { "username", t_text }, { "type", t_text }, { "message", t_text }, { "time", t_text } } };
+constexpr schema<3> s_work{ "work",
+    { { "username", t_text }, { "date", t_date }, { "status", t_text } } };
+constexpr schema<8> s_question{ "question",
+    { { "name", t_text }, { "gender", t_text }, { "age", t_int }, { "height", t_decimal },
+      { "weight", t_decimal }, { "heart", t_int }, { "pressure", t_int }, { "lung", t_int } } };
+
+// ---------------- 取值解析 ----------------
+
+inline bool parse_int(std::string_view s, long long &v)
+{
+    size_t i = !s.empty() && (s[0] == '-' || s[0] == '+');
+    if(i >= s.size()) return false;
+    v = 0;
+    for(size_t k = i; k < s.size(); ++k)
+    {
+        if(s[k] < '0' || s[k] > '9') return false;
+        v = v * 10 + (s[k] - '0');
+    }
+    if(s[0] == '-') v = -v;
+    return true;
+}
+inline bool parse_decimal(std::string_view s, double &v)
+{
+    if(s.empty() || s.size() > 64) return false;
+    std::string t(s);
+    char *end;
+    v = std::strtod(t.c_str(), &end);
+    return *end == 0 && t.find_first_of("eExXnN") == std::string::npos;
+}
+// YYYYMMDD 或 YYYY-MM-DD, 解析成 yyyymmdd
+inline bool parse_date(std::string_view s, int &v)
+{
+    std::string d;
+    for(char c : s) if(c != '-' && c != '/') d += c;
+    long long x;
+    if(d.size() != 8 || !parse_int(d, x)) return false;
+    int m = x / 100 % 100, day = x % 100;
+    return v = x, 1 <= m && m <= 12 && 1 <= day && day <= 31;
+}
+// H / HH:MM / HH:MM:SS, 解析成当天的秒数
+inline bool parse_time(std::string_view s, int &v)
+{
+    long long part[3] = { 0, 0, 0 };
+    for(size_t n = 0, b = 0, e;; b = e + 1)
+    {
+        e = s.find(':', b);
+        if(n == 3 || !parse_int(s.substr(b, e == s.npos ? e : e - b), part[n])) return false;
+        if(part[n++] < 0) return false;
+        if(e == s.npos) break;
+    }
+    if(part[0] > 24 || part[1] > 59 || part[2] > 59) return false;
+    return v = part[0] * 3600 + part[1] * 60 + part[2], true;
+}
+
+// 请求里的标量可能是字符串也可能是数字, 统一取文本
+inline std::string scalar_text(const nlohmann::json &k)
+{
+    return k.is_string() ? k.get<std::string>() : k.dump();
+}
+inline std::string two_digits(int x) { return { char('0' + x / 10 % 10), char('0' + x % 10) }; }
+inline std::string quote_sql(std::string_view s)
+{
+    std::string ret = "'";
+    for(char c : s)
+    {
+        if(c == '\'' || c == '\\') ret += '\\';
+        if(c == 0) { ret += "\\0"; continue; }
+        ret += c;
+    }
+    return ret + '\'';
+}
+
+template<col_type T> struct cpp_type { using type = std::string_view; };
+template<> struct cpp_type<t_int> { using type = long long; };
+template<> struct cpp_type<t_decimal> { using type = double; };
+template<> struct cpp_type<t_date> { using type = int; };  // yyyymmdd
+template<> struct cpp_type<t_time> { using type = int; };  // 当天秒数
+
+// ---------------- 由 schema 生成的 SQL 模板 ----------------
+
+template<const auto &S>
+std::string column_list()
+{
+    std::string ret;
+    for(int i = 0; i < S.size(); ++i) ret += std::string(i ? ", " : "") + '`' + S.col[i].name + '`';
+    return ret;
+}
+template<const auto &S>
+const std::string &select_sql()
+{
+    static const std::string sql = "SELECT " + column_list<S>() + " FROM `" + S.name + "`";
+    return sql;
+}
+template<const auto &S>
+const std::string &insert_head()
+{
+    static const std::string sql = "INSERT INTO `" + std::string(S.name) + "` (" + column_list<S>() + ") VALUES ";
+    return sql;
+}
+template<const auto &S>
+const std::string &upsert_tail()
+{
+    static const std::string sql = []
+    {
+        std::string s = " ON DUPLICATE KEY UPDATE";
+        for(int i = 0; i < S.size(); ++i)
+            s += std::string(i ? "," : "") + " `" + S.col[i].name + "` = VALUES(`" + S.col[i].name + "`)";
+        return s;
+    }();
+    return sql;
+}
+
+// ---------------- 一行记录 ----------------
+
+// 文本列只保存指向请求 JSON / 查询结果行 / 调用方字符串的 string_view, 不复制内容,
+// 因此 record 不能比这些数据活得更久, 也不允许拷贝
+template<const auto &S>
+class record
+{
+public:
+    static constexpr int N = S.size();
+
+    record() = default;
+    record(const record&) = delete;
+    record &operator=(const record&) = delete;
+
+    // 查询结果中的一行, 列顺序与 S 一致(用 select_sql<S>() 查询即可保证)
+    void decode(const std::vector<std::string> &row)
+    {
+        for(int i = 0; i < N && i < int(row.size()); ++i) parse(i, row[i]);
+    }
+    // 请求中的对象, 已经 set 过的列跳过; 返回空串表示成功, 否则为 "no [列]" 或 "bad [列]"
+    std::string read(const nlohmann::json &j)
+    {
+        for(int i = 0; i < N; ++i)
+        {
+            if(given[i]) continue;
+            auto it = j.find(S.col[i].name);
+            if(it == j.end()) return "no [" + std::string(S.col[i].name) + ']';
+            std::string_view s = it->is_string() ? std::string_view(it->template get_ref<const std::string&>())
+                                                 : std::string_view(own[i] = it->dump());
+            if(!parse(i, s)) return "bad [" + std::string(S.col[i].name) + ']';
+        }
+        return "";
+    }
+    // 由服务端直接给定某一列的值
+    bool set(int i, std::string_view s) { return given[i] = true, parse(i, s); }
+    std::string_view text(int i) const { return raw[i]; }
+
+    template<int I>
+    typename cpp_type<S.col[I].type>::type get() const
+    {
+        constexpr col_type t = S.col[I].type;
+        if constexpr(t == t_text) return raw[I];
+        else if constexpr(t == t_decimal) return dec[I];
+        else if constexpr(t == t_int) return num[I];
+        else return int(num[I]);
+    }
+
+    // 第 i 列按类型规范化后的 SQL 字面量
+    std::string literal(int i) const
+    {
+        switch(S.col[i].type)
+        {
+        case t_int: return std::to_string(num[i]);
+        case t_decimal: return std::string(raw[i]);
+        case t_date: case t_time: return '\'' + canonical(i) + '\'';
+        default: return quote_sql(raw[i]);
+        }
+    }
+    // 日期/时间列按数据库返回的格式("YYYY-MM-DD", "HH:MM:SS")写出, 请求里的其他写法也得到同样的文本
+    std::string canonical(int i) const
+    {
+        if(S.col[i].type == t_date)
+            return std::to_string(num[i] / 10000) + '-' + two_digits(num[i] / 100) + '-' + two_digits(num[i]);
+        if(S.col[i].type == t_time)
+            return two_digits(num[i] / 3600) + ':' + two_digits(num[i] / 60 % 60) + ':' + two_digits(num[i] % 60);
+        return std::string(raw[i]);
+    }
+    // "(v1, v2, ...)"
+    std::string values() const
+    {
+        std::string ret = "(";
+        for(int i = 0; i < N; ++i) ret += (i ? ", " : "") + literal(i);
+        return ret + ')';
+    }
+    nlohmann::json to_json() const
+    {
+        nlohmann::json ret;
+        for(int i = 0; i < N; ++i)
+        {
+            // 由请求构造的记录(如变更推送)和查询结果的同一行要写得一样, 客户端才能按键对上
+            if(S.col[i].type == t_time && ok[i] && num[i] % 3600 == 0)
+                ret[S.col[i].name] = std::to_string(num[i] / 3600);
+            else if((S.col[i].type == t_date || S.col[i].type == t_time) && ok[i]) ret[S.col[i].name] = canonical(i);
+            else ret[S.col[i].name] = std::string(raw[i]);
+        }
+        return ret;
+    }
+
+private:
+    bool parse(int i, std::string_view s)
+    {
+        raw[i] = s, num[i] = 0, dec[i] = 0;
+        int x = 0;
+        switch(S.col[i].type)
+        {
+        case t_int: ok[i] = parse_int(s, num[i]); break;
+        case t_decimal: ok[i] = parse_decimal(s, dec[i]); break;
+        case t_date: ok[i] = parse_date(s, x), num[i] = x; break;
+        case t_time: ok[i] = parse_time(s, x), num[i] = x; break;
+        default: ok[i] = true;
+        }
+        return ok[i];
+    }
+
+    std::string_view raw[N];
+    std::string own[N];  // 数字形式的 JSON 值转成的文本
+    long long num[N] = { };
+    double dec[N] = { };
+    bool ok[N] = { }, given[N] = { };
+};
+
+template<const auto &S>
+nlohmann::json row_to_json(const std::vector<std::string> &row)
+{
+    record<S> r;
+    return r.decode(row), r.to_json();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+// 病历/医嘱全文检索: 文本按 UTF-8 字符切成单字和相邻两字(bigram), 建 term -> 记录 的倒排表,
+// 中文无需分词也能做子串匹配; 查询词同样切分, 要求全部命中, 按 tf-idf 打分排序
+
+#include<cmath>
+#include<mutex>
+#include<cctype>
+#include<string>
+#include<vector>
+#include<algorithm>
+#include<string_view>
+#include<shared_mutex>
+#include<unordered_map>
+#include<nlohmann/json.hpp>
+
+// 按字符切分, ASCII 字母转小写, 标点和空白作为分隔(返回空串)
+inline std::vector<std::string> split_chars(std::string_view s)
+{
+    std::vector<std::string> ret;
+    for(size_t i = 0; i < s.size();)
+    {
+        unsigned char c = s[i];
+        size_t n = c < 0x80 ? 1 : c >> 5 == 6 ? 2 : c >> 4 == 14 ? 3 : c >> 3 == 30 ? 4 : 1;
+        if(i + n > s.size()) n = s.size() - i;
+        std::string ch(s.substr(i, n));
+        i += n;
+        if(n == 1)
+        {
+            if(!std::isalnum(c)) ch.clear();
+            else ch[0] = std::tolower(c);
+        }
+        else if(n == 3)
+        {
+            unsigned cp = (c & 15) << 12 | (ch[1] & 63) << 6 | (ch[2] & 63);
+            // CJK 标点与全角标点
+            if((0x3000 <= cp && cp <= 0x303f) || (0xff00 <= cp && cp <= 0xff0f) ||
+               (0xff1a <= cp && cp <= 0xff20) || (0xff3b <= cp && cp <= 0xff40) ||
+               (0xff5b <= cp && cp <= 0xff65))
+                ch.clear();
+        }
+        ret.push_back(std::move(ch));
+    }
+    return ret;
+}
+
+// 建索引时收录全部单字和 bigram; 查询时每段只取 bigram, 只有一个字的段取单字
+inline std::vector<std::string> ngrams(std::string_view s, bool query)
+{
+    std::vector<std::string> c = split_chars(s), ret;
+    for(size_t b = 0, e; b < c.size(); b = e + 1)
+    {
+        for(e = b; e < c.size() && !c[e].empty(); ++e);
+        if(e == b) continue;
+        if(!query || e - b == 1) for(size_t i = b; i < e; ++i) ret.push_back(c[i]);
+        for(size_t i = b; i + 1 < e; ++i) ret.push_back(c[i] + c[i + 1]);
+    }
+    return ret;
+}
+
+class text_index
+{
+public:
+    // key 唯一标识一条记录, 再次 put 同一 key 时替换旧内容
+    void put(const std::string &key, const std::string &patient, const std::string &doctor,
+             const std::string &text, nlohmann::json row)
+    {
+        std::vector<std::string> terms = ngrams(text, false);
+        std::unique_lock<std::shared_mutex> lock(mu);
+        auto it = by_key.find(key);
+        int id;
+        if(it != by_key.end()) id = it->second, unlink(id);
+        else id = docs.size(), by_key[key] = id, docs.emplace_back();
+        document &d = docs[id];
+        d.patient = patient, d.doctor = doctor, d.row = std::move(row), d.terms.clear();
+        for(auto &t : terms) if(!postings[t][id]++) d.terms.push_back(t);
+    }
+
+    // 只在 user 作为医生(by_doctor)或患者的记录里查, 返回按相关度排好的前 limit 条
+    std::vector<nlohmann::json> search(std::string_view query, bool by_doctor,
+                                       std::string_view user, size_t limit) const
+    {
+        std::vector<std::string> terms = ngrams(query, true);
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+        std::vector<nlohmann::json> ret;
+        if(terms.empty()) return ret;
+        std::shared_lock<std::shared_mutex> lock(mu);
+        std::unordered_map<int, std::pair<size_t, double>> hit;
+        for(auto &t : terms)
+        {
+            auto p = postings.find(t);
+            if(p == postings.end()) return ret;
+            double idf = std::log(1.0 + double(docs.size()) / p->second.size());
+            for(auto &[id, tf] : p->second)
+            {
+                const document &d = docs[id];
+                if((by_doctor ? d.doctor : d.patient) != user) continue;
+                auto &h = hit[id];
+                ++h.first, h.second += idf * (1 + std::log(double(tf)));
+            }
+        }
+        std::vector<std::pair<double, int>> rank;
+        for(auto &[id, h] : hit) if(h.first == terms.size()) rank.push_back({ -h.second, id });
+        size_t n = std::min(limit, rank.size());
+        std::partial_sort(rank.begin(), rank.begin() + n, rank.end());
+        for(size_t i = 0; i < n; ++i) ret.push_back(docs[rank[i].second].row);
+        return ret;
+    }
+
+    size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mu);
+        return by_key.size();
+    }
+
+private:
+    struct document
+    {
+        std::string patient, doctor;
+        nlohmann::json row;
+        std::vector<std::string> terms;
+    };
+
+    void unlink(int id)
+    {
+        for(auto &t : docs[id].terms)
+        {
+            auto p = postings.find(t);
+            p->second.erase(id);
+            if(p->second.empty()) postings.erase(p);
+        }
+    }
+
+    mutable std::shared_mutex mu;
+    std::unordered_map<std::string, int> by_key;
+    std::vector<document> docs;
+    std::unordered_map<std::string, std::unordered_map<int, int>> postings;  // term -> 记录号 -> 出现次数
+};
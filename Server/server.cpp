@@ -4,9 +4,26 @@
 #include<map>
 #include<exception>
 #include<thread>
+#include<ctime>
+#include<random>
 #include<boost/asio.hpp>
 #include<nlohmann/json.hpp>
 #include<mysql/mysql.h>
+#include"admission.h"
+#include"reaper.h"
+#include"cluster.h"
+#include"router.h"
+#include"batcher.h"
+#include"schema.h"
+#include"request.h"
+#include"search.h"
+#include"directory.h"
+#include"schedule.h"
+#include"waitlist.h"
+#include"timers.h"
+#include"notices.h"
+#include"feeds.h"
+#include"outbox.h"
 
 #define fcc(i, j, k) for(int (i)=(j); (i)<=(k); ++(i))
 
@@ -22,47 +39,118 @@ constexpr char dbuser[] = "myuser";
 constexpr char dbpassword[] = "bit123456";
 constexpr char dbname[] = "SmartMedical";
 constexpr int dbport = 3306;
-const vs vs_account{ "username", "type", "reverse" };
-const vs vs_patientInfo{ "username", "name", "gender", "birthday", "id", "phoneNumber", "email" };
-const vs vs_doctorInfo{ "username", "name", "id", "department", "cost", "begin", "end", "limit" };
-const vs vs_namelist{ "username", "name" };
-const vs vs_appointment{ "patientUsername", "doctorUsername", "date", "time", "cost", "status" };
-const vs vs_case
-{ "patientUsername", "doctorUsername", "date", "time", "main", "now", "past", "check", "diagnose" };
-const vs vs_advice
-{ "patientUsername", "doctorUsername", "date", "time", "medicine", "check", "therapy", "care" };
-const vs vs_notice{ "username", "type", "message", "time" };
-const vs vs_work{ "username", "date", "status" };
-const vs vs_question{ "name", "gender", "age", "height", "weight", "heart", "pressure", "lung" };
+constexpr int oltp_limit = 32, oltp_queue = 128;
+constexpr int olap_limit = 2, olap_queue = 4;
+constexpr int min_inflight = 4, max_inflight = 32;
+constexpr int max_queue_ms = 500;
+constexpr int idle_timeout = 1800, write_timeout = 10, wheel_slots = 2048;
+constexpr int outbox_writers = 4;
+constexpr size_t outbox_limit = 4 << 20;
+constexpr char bus_prefix[] = "/tmp/hospital_bus";
+constexpr int db_pool_size = 8, db_sticky_ms = 2000;
+constexpr int batch_rows = 256, batch_delay_ms = 5;
+constexpr int search_limit = 20, max_search_limit = 100;
+constexpr int schedule_days = 1 << 16;
+constexpr int reminder_tick_ms = 1000, reminder_batch = 500;
+constexpr int notice_batch = 100;
+constexpr int session_ttl_hours = 12;
+constexpr int sync_overlap_seconds = 2;
+constexpr size_t max_request = 1 << 20;
 
 template<typename T>
 inline void max_(T &t, const T &u) { if(t < u) t = u; }
 
-MYSQL *database = mysql_init(0);
+// 连接池经 MySQL C API 建立连接
+struct mysql_driver
+{
+    using handle = MYSQL*;
+    static MYSQL *connect(const db_endpoint &e, const char *user, const char *password, const char *name, std::string &error)
+    {
+        MYSQL *c = mysql_init(0);
+        if(mysql_real_connect(c, e.host.c_str(), user, password, name, e.port, 0, 0)) return c;
+        error = mysql_error(c), mysql_close(c);
+        return 0;
+    }
+    static void close(MYSQL *c) { mysql_close(c); }
+};
+using db_router = basic_db_router<mysql_driver>;
+db_router router(std::chrono::milliseconds(env_int("DB_STICKY_MS", db_sticky_ms)));
 std::set<tcp::socket*> chat_socket;
-
-inline std::string reply_format(std::string s) { return "{\"reply\":\"" + s + "\"}\n"; }
-template<typename T>
-inline std::string par_format(T t) { return '\'' + std::string(t) + '\''; }
-template<typename T>
-inline std::string par_format(std::string s, T t) { return '`' + s + "` = " + par_format(t); }
-void reply_str(tcp::socket &socket, std::string s)
+std::mutex chat_mutex;
+bus event_bus;
+text_index search_index;
+patient_directory patients;
+day_table schedule(schedule_days);  // 在 main 里 fork 之前就已映射, worker 共享
+doctor_rules rules;
+waitlist waiting;
+struct reminder
+{
+    std::string patient, doctor;
+    int date, time;
+};
+timer_wheel<reminder> reminders{ std::chrono::milliseconds(reminder_tick_ms) };
+bool reminder_owner = false;  // 只有 0 号 worker 持有提醒时间轮, 避免重复提醒
+const int reminder_lead = env_int("REMINDER_LEAD_MIN", 60) * 60;
+notice_hub notice_subs;
+change_feed feeds;
+admission gate(oltp_limit, oltp_queue, olap_limit, olap_queue,
+               min_inflight, max_inflight, std::chrono::milliseconds(max_queue_ms));
+reaper idle_reaper(idle_timeout, write_timeout, wheel_slots, [](tcp::socket *s)
+{
+    {
+        std::lock_guard<std::mutex> lock(chat_mutex);
+        chat_socket.erase(s);
+    }
+    notice_subs.unsubscribe(s);
+    feeds.unsubscribe(s);
+});
+// 所有写 socket 的地方都经过各连接的发送队列, 不同线程写同一连接时帧不会交错;
+// 积压超过 outbox_limit 字节的连接被断开
+outbox outbound([](tcp::socket *socket, const std::string &s)
 {
     std::cout << "<-- " << s, std::cout.flush();
-    boost::asio::write(socket, boost::asio::buffer(s));
-}
-void reply_json(tcp::socket &socket, json j) { reply_str(socket, j.dump() + newl); }
-int get_json(json &j, json k, std::string s)
+    boost::system::error_code ec;
+    idle_reaper.begin_write(socket);
+    boost::asio::write(*socket, boost::asio::buffer(s), ec);
+    idle_reaper.end_write(socket);
+}, outbox_limit);
+
+inline std::string reply_format(const std::string &s) { return "{\"reply\":\"" + s + "\"}\n"; }
+inline std::string par_format(std::string_view t) { return quote_sql(t); }
+inline std::string par_format(std::string_view s, std::string_view t) { return '`' + std::string(s) + "` = " + par_format(t); }
+// 当前请求带的 id, 只加在发给这个连接的第一条回复上, 客户端据此把回复交给发出请求的窗口
+thread_local tcp::socket *request_socket = 0;
+thread_local std::string request_id;
+void reply_str(tcp::socket &socket, const std::string &s)
 {
-    if(!k.contains(s)) return 1;
-    return j = k[s], 0;
+    if(&socket == request_socket && s.size() > 1 && s[0] == '{')
+    {
+        request_socket = 0;
+        return reply_str(socket, "{\"id\":" + request_id + (s[1] == '}' ? "" : ",") + s.substr(1));
+    }
+    outbound.send(&socket, s);
 }
-json vs_to_json(vs col, vs v)
+// 请求带 version(客户端缓存的内容版本, 可为空)时, 回复附上内容的版本号; 与客户端的版本相同时只回 notModified
+thread_local tcp::socket *version_socket = 0;
+thread_local std::string request_version;
+std::string content_version(const std::string &s)
 {
-    json ret;
-    fcc(i, 1, v.size()) ret[col[i - 1]] = v[i - 1];
+    unsigned long long h = 14695981039346656037ull;  // FNV-1a
+    for(unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+    static const char hex[] = "0123456789abcdef";
+    std::string ret;
+    for(int k = 60; k >= 0; k -= 4) ret += hex[h >> k & 15];
     return ret;
 }
+void reply_json(tcp::socket &socket, const json &j)
+{
+    std::string s = j.dump();
+    if(&socket != version_socket || s.size() <= 2) return reply_str(socket, s + newl);
+    version_socket = 0;
+    std::string v = content_version(s);
+    if(v == request_version) return reply_str(socket, "{\"reply\":\"notModified\",\"version\":\"" + v + "\"}\n");
+    reply_str(socket, "{\"version\":\"" + v + "\"," + s.substr(1) + newl);
+}
 std::string int_to_str(int i)
 {
     std::string ret;
@@ -70,26 +158,22 @@ std::string int_to_str(int i)
     if(ret.empty()) ret += '0';
     return std::reverse(ret.begin(), ret.end()), ret;
 }
-int str_to_int(std::string s)
-{
-    int ret = 0;
-    for(auto c : s) ret = (ret << 1) + (ret << 3) + (c ^ 48);
-    return ret;
-}
 
-void print_vvs(vvs v)
+void print_vvs(const vvs &v)
 {
     int col = v.empty() ? 0 : v[0].size();
     fcc(i, 1, v.size()) fcc(j, 1, col) std::cout << v[i - 1][j - 1] << snewl[j == col];
     std::cout.flush();
 }
-vvs execute_sql(std::string sql)
+vvs execute_sql(const std::string &sql)
 {
     std::cout << "<<< " << sql << newl, std::cout.flush();
     vvs ret;
-    if(!mysql_query(database, sql.c_str()))
+    bool ok;
+    db_router::lease conn = router.execute(is_write_sql(sql), [&](MYSQL *c) { return !mysql_query(c, sql.c_str()); }, ok);
+    if(ok)
     {
-        MYSQL_RES *result = mysql_store_result(database);
+        MYSQL_RES *result = mysql_store_result(conn);
         if(result)
         {
             int col = mysql_num_fields(result);
@@ -104,40 +188,468 @@ vvs execute_sql(std::string sql)
                 fcc(i, 0, col - 1) vs.push_back(row[i] ? row[i] : "NULL");
                 ret.push_back(vs);
             }
+            mysql_free_result(result);
         }
     }
     std::cout << ">>> " << newl, print_vvs(ret);
     return ret;
 }
-std::string insert_sql(std::string table, vs col, json j)
+// 写语句影响的行数, 失败时为 -1
+long long affected_sql(const std::string &sql)
+{
+    std::cout << "<<< " << sql << newl, std::cout.flush();
+    db_router::lease conn = router.route(true);
+    if(mysql_query(conn, sql.c_str())) return -1;
+    return mysql_affected_rows(conn);
+}
+template<const auto &S>
+constexpr bool is_feed = static_cast<const void*>(&S) == &s_appointment ||
+                         static_cast<const void*>(&S) == &s_case || static_cast<const void*>(&S) == &s_advice;
+// 预约/病历/医嘱的前四列 (patientUsername, doctorUsername, date, time) 确定一行.
+// 总线装不下整行时只发这四列, 收到的 worker 按它从主库把这一行读回来
+template<const auto &S>
+json row_key(const json &row)
+{
+    json k;
+    fcc(i, 0, 3) if(row.contains(S.col[i].name)) k[S.col[i].name] = row[S.col[i].name];
+    return k;
+}
+template<const auto &S>
+bool reload_row(const json &k, json &row)
+{
+    record<S> key;
+    std::string where;
+    fcc(i, 0, 3)
+    {
+        auto it = k.find(S.col[i].name);
+        if(it == k.end() || !it->is_string() || !key.set(i, it->template get_ref<const std::string&>())) return false;
+        where += std::string(i ? " AND `" : "`") + S.col[i].name + "` = " + key.literal(i);
+    }
+    router.mark_write();  // 写入方刚提交, 从库可能还没有这一行
+    vvs v = execute_sql(select_sql<S>() + " WHERE " + where);
+    if(v.size() < 2) return false;
+    return row = row_to_json<S>(v[1]), true;
+}
+bool reload_row(std::string_view kind, const json &k, json &row)
+{
+    if(kind == s_appointment.name) return reload_row<s_appointment>(k, row);
+    if(kind == s_case.name) return reload_row<s_case>(k, row);
+    if(kind == s_advice.name) return reload_row<s_advice>(k, row);
+    return false;
+}
+// 行变更经总线发到各 worker, 由 push_change 推给订阅者
+void publish_change(const char *entity, const char *op, json row)
+{
+    json e;
+    e["entity"] = entity, e["op"] = op, e["row"] = std::move(row);
+    std::string payload = e.dump();
+    if(!event_bus.fits("change", payload))
+    {
+        std::string_view kind(entity);
+        e["row"] = kind == s_appointment.name ? row_key<s_appointment>(e["row"]) :
+                   kind == s_case.name ? row_key<s_case>(e["row"]) : row_key<s_advice>(e["row"]);
+        e["reload"] = true, payload = e.dump();
+    }
+    event_bus.publish("change", payload);
+}
+void push_change(const std::string &payload)
+{
+    json ret;
+    ret["reply"] = "change", ret["data"] = json::parse(payload);
+    if(ret["data"].value("reload", false))
+    {
+        json row;
+        if(!reload_row(ret["data"]["entity"].get<std::string>(), ret["data"]["row"], row)) return;
+        ret["data"]["row"] = std::move(row), ret["data"].erase("reload");
+    }
+    const json &row = ret["data"]["row"];
+    std::string s = ret.dump() + newl;
+    std::vector<std::shared_ptr<outbox::peer>> to;
+    feeds.broadcast(ret["data"]["entity"].get<std::string>(), row["patientUsername"].get<std::string>(),
+                    row["doctorUsername"].get<std::string>(), [&](tcp::socket *socket)
+                    {
+                        if(auto p = outbound.find(socket)) to.push_back(std::move(p));
+                    });
+    for(auto &p : to) outbound.push(p, s);
+}
+// upsert 影响 1 行为新插入, 2 行为更新了已有行, 0 行为内容未变; also 为更新已有行时额外要改的列(", `c` = v")
+template<const auto &S>
+std::string insert_sql(const record<S> &r, const char *also = "")
+{
+    long long n = affected_sql(insert_head<S>() + r.values() + upsert_tail<S>() + also);
+    if constexpr(is_feed<S>) if(n > 0) publish_change(S.name, n == 1 ? "insert" : "update", r.to_json());
+    return n < 0 ? "failed" : "successful";
+}
+template<const auto &S>
+std::string insert_sql(const json &j)
+{
+    record<S> r;
+    std::string error = r.read(j);
+    return error.empty() ? insert_sql(r) : error;
+}
+bool execute_transaction(const std::vector<std::string> &sql)
+{
+    db_router::lease conn = router.route(true);
+    if(mysql_query(conn, "START TRANSACTION")) return false;
+    for(auto &s : sql)
+    {
+        std::cout << "<<< " << s << newl, std::cout.flush();
+        if(mysql_query(conn, s.c_str())) return mysql_query(conn, "ROLLBACK"), false;
+    }
+    return !mysql_query(conn, "COMMIT");
+}
+write_behind batcher(batch_rows, std::chrono::milliseconds(batch_delay_ms), execute_transaction);
+// WRITE_BEHIND_ACK=enqueue 时入队即回复, 否则等所在批次提交后再回复
+const bool ack_on_enqueue = std::getenv("WRITE_BEHIND_ACK") &&
+                            std::string(std::getenv("WRITE_BEHIND_ACK")) == "enqueue";
+template<const auto &S>
+std::string queue_sql(const record<S> &r)
+{
+    router.mark_write();
+    auto flushed = batcher.push(S.name, insert_head<S>(), upsert_tail<S>(), r.values());
+    if(ack_on_enqueue) return "successful";
+    return flushed.get() ? "successful" : "failed";
+}
+
+// 病历/医嘱的前四列是 patientUsername, doctorUsername, date, time, 其余列为可检索的文本;
+// 同一患者、医生、日期、时间的记录视为同一条, 新写入的覆盖旧的
+template<const auto &S>
+json search_entry(const record<S> &r)
+{
+    json e;
+    std::string text;
+    fcc(i, 4, S.size() - 1) text += std::string(r.text(i)) + newl;
+    e["key"] = std::string(S.name) + '/' + std::string(r.text(0)) + '/' + std::string(r.text(1)) + '/' +
+               int_to_str(r.template get<2>()) + '/' + int_to_str(r.template get<3>());
+    e["patient"] = r.text(0), e["doctor"] = r.text(1), e["text"] = text;
+    e["row"] = r.to_json(), e["row"]["kind"] = S.name;
+    return e;
+}
+void index_search_entry(json e)
+{
+    search_index.put(e["key"], e["patient"], e["doctor"], e["text"], std::move(e["row"]));
+}
+// 只带键的条目(总线装不下整条时发出)由收到的 worker 自己读库重建
+template<const auto &S>
+void reload_search_entry(const json &k)
+{
+    json row;
+    if(!reload_row<S>(k, row)) return;
+    record<S> r;
+    if(r.read(row).empty()) index_search_entry(search_entry(r));
+}
+void put_search_entry(const std::string &payload)
+{
+    json e = json::parse(payload);
+    if(!e.contains("reload")) return index_search_entry(std::move(e));
+    if(e["reload"] == s_case.name) reload_search_entry<s_case>(e["key"]);
+    if(e["reload"] == s_advice.name) reload_search_entry<s_advice>(e["key"]);
+}
+template<const auto &S>
+void load_search_index()
+{
+    vvs v = execute_sql(select_sql<S>());
+    if(!v.empty()) fcc(i, 1, v.size() - 1)
+    {
+        record<S> r;
+        r.decode(v[i]);
+        index_search_entry(search_entry(r));
+    }
+}
+// 写库成功后经总线更新所有 worker 的索引
+template<const auto &S>
+std::string insert_indexed(const record<S> &r)
+{
+    std::string s = insert_sql(r);
+    if(s != "successful") return s;
+    std::string payload = search_entry(r).dump();
+    if(!event_bus.fits("search", payload))
+    {
+        json e;
+        e["reload"] = S.name, e["key"] = row_key<S>(r.to_json());
+        payload = e.dump();
+    }
+    event_bus.publish("search", payload);
+    return s;
+}
+void put_patient(const std::string &payload)
+{
+    json e = json::parse(payload);
+    patients.put(e["username"], e["name"]);
+}
+void publish_patient(std::string_view username, std::string_view name)
+{
+    json e;
+    e["username"] = username, e["name"] = name;
+    event_bus.publish("patient", e.dump());
+}
+void load_patient_directory()
+{
+    vvs v = execute_sql(
+        "SELECT a.username, p.name FROM account a "
+        "INNER JOIN patientInfo p ON a.username = p.username "
+        "WHERE a.type = 'patient'");
+    if(!v.empty()) fcc(i, 1, v.size() - 1) patients.put(v[i][0], v[i][1]);
+}
+int today()
+{
+    std::time_t t = std::time(0);
+    std::tm tm;
+    localtime_r(&t, &tm);
+    return (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+}
+std::string date_text(int date)
+{
+    return std::to_string(date / 10000) + '-' + two_digits(date / 100) + '-' + two_digits(date);
+}
+std::string now_text()
+{
+    std::time_t t = std::time(0);
+    std::tm tm;
+    char buf[32];
+    localtime_r(&t, &tm);
+    return std::string(buf, std::strftime(buf, sizeof buf, "%Y-%m-%d %H:%M:%S", &tm));
+}
+std::string slot_text(int slot)
+{
+    int t = slot * day_table::slot_seconds;
+    return two_digits(t / 3600) + ':' + two_digits(t / 60 % 60);
+}
+void put_doctor_rule(const std::string &payload)
+{
+    json e = json::parse(payload);
+    rules.put(e["username"], { e["limit"], e["begin"], e["end"] });
+}
+void publish_doctor_rule(std::string_view username, doctor_rule rule)
+{
+    json e;
+    e["username"] = username, e["limit"] = rule.limit, e["begin"] = rule.begin, e["end"] = rule.end;
+    event_bus.publish("doctor", e.dump());
+}
+doctor_rule rule_of(const record<s_doctorInfo> &r)
+{
+    return { int(r.get<s_doctorInfo.index("limit")>()), r.get<s_doctorInfo.index("begin")>(),
+             r.get<s_doctorInfo.index("end")>() };
+}
+std::string time_text(int t)
+{
+    return two_digits(t / 3600) + ':' + two_digits(t / 60 % 60) + ':' + two_digits(t % 60);
+}
+// 把 id 在已推送位置之后、属于这个订阅者的通知成批放进它的发送队列; 调用方持有 s.mu, 放开后再 schedule
+void push_notices(notice_hub::subscriber &s, outbox::peer &p)
+{
+    for(size_t n = notice_batch; s.socket && n == notice_batch;)
+    {
+        router.mark_write();  // 刚写入的通知可能还没同步到从库
+        vvs v = execute_sql(
+            "SELECT `id`, " + column_list<s_notice>() + " FROM `notice` WHERE `id` > " + std::to_string(s.pushed) + " AND (" +
+            par_format("type", "admin") + " OR (" + par_format("username", s.username) + " AND " +
+            par_format("type", s.type) + ")) ORDER BY `id` LIMIT " + int_to_str(notice_batch));
+        n = v.empty() ? 0 : v.size() - 1;
+        if(!n) break;
+        json ret;
+        ret["reply"] = "notice";
+        fcc(i, 1, n)
+        {
+            json k = row_to_json<s_notice>(std::vector<std::string>(v[i].begin() + 1, v[i].end()));
+            k["id"] = std::stoll(v[i][0]);
+            ret["data"]["notice_" + int_to_str(i)] = k;
+        }
+        outbound.post(p, ret.dump() + newl);
+        s.pushed = std::stoll(v[n][0]);
+    }
+}
+void push_notices(notice_hub::subscriber &s)
+{
+    std::shared_ptr<outbox::peer> p;
+    {
+        std::lock_guard<std::mutex> lock(s.mu);
+        if(s.socket && (p = outbound.find(s.socket))) push_notices(s, *p);
+    }
+    if(p) outbound.schedule(p);
+}
+// 总线上收到某用户有新通知(空用户名表示全员通知), 给本 worker 上对应的订阅者补推
+void sync_notices(const std::string &username)
+{
+    for(auto &s : notice_subs.targets(username)) push_notices(*s);
+}
+void publish_notice(std::string_view username) { event_bus.publish("notice", std::string(username)); }
+void add_reminder(reminder r)
+{
+    std::tm tm{ };
+    tm.tm_year = r.date / 10000 - 1900, tm.tm_mon = r.date / 100 % 100 - 1, tm.tm_mday = r.date % 100;
+    tm.tm_sec = r.time - reminder_lead, tm.tm_isdst = -1;
+    reminders.add(std::chrono::system_clock::from_time_t(std::mktime(&tm)), std::move(r));
+}
+void put_reminder(const std::string &payload)
+{
+    if(!reminder_owner) return;
+    json e = json::parse(payload);
+    add_reminder({ e["patient"], e["doctor"], e["date"], e["time"] });
+}
+void schedule_reminder(std::string_view patient, std::string_view doctor, int date, int time)
+{
+    json e;
+    e["patient"] = patient, e["doctor"] = doctor, e["date"] = date, e["time"] = time;
+    event_bus.publish("reminder", e.dump());
+}
+// 启动时直接放进本进程的时间轮: 这时总线还没有注册处理函数, 经总线发出的提醒会丢失
+void load_reminders()
+{
+    if(!reminder_owner) return;
+    vvs v = execute_sql(
+        "SELECT `patientUsername`, `doctorUsername`, `date`, `time` FROM `appointment` "
+        "WHERE `status` <> 'cancelled' AND `reminded` = 0 AND `date` >= CURDATE()");
+    int date, time;
+    if(!v.empty()) fcc(i, 1, v.size() - 1)
+        if(parse_date(v[i][2], date) && parse_time(v[i][3], time))
+            add_reminder({ v[i][0], v[i][1], date, time });
+}
+// 每个 tick 取出到期的提醒, 每 reminder_batch 条合成一次 INSERT ... SELECT, 已取消或已提醒过的预约自然被跳过
+void run_reminders()
 {
-    std::string sql = "INSERT INTO `" + table + "` VALUES (";
-    fcc(i, 1, col.size())
+    for(;;)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(reminder_tick_ms));
+        std::vector<reminder> due = reminders.advance(std::chrono::system_clock::now());
+        for(size_t b = 0; b < due.size(); b += reminder_batch)
+        {
+            std::string match;
+            for(size_t i = b; i < due.size() && i < b + reminder_batch; ++i)
+                match += std::string(i > b ? " OR " : "") + '(' +
+                         par_format("patientUsername", due[i].patient) + " AND " +
+                         par_format("doctorUsername", due[i].doctor) + " AND " +
+                         "`date` = " + quote_sql(date_text(due[i].date)) + " AND " +
+                         "`time` = " + quote_sql(time_text(due[i].time)) + ')';
+            std::string where = "`status` <> 'cancelled' AND `reminded` = 0 AND (" + match + ')';
+            bool ok = execute_transaction({
+                "INSERT INTO `notice` (`username`, `type`, `message`, `time`) "
+                "SELECT `patientUsername`, 'patient', CONCAT('您预约的 ', `doctorUsername`, ' 医生 ', `date`, ' ', "
+                "TIME_FORMAT(`time`, '%H:%i'), ' 的门诊即将开始'), NOW() FROM `appointment` WHERE " + where,
+                "UPDATE `appointment` SET `reminded` = 1 WHERE " + where });
+            std::set<std::string> notified;
+            for(size_t i = b; ok && i < due.size() && i < b + reminder_batch; ++i)
+                if(notified.insert(due[i].patient).second) publish_notice(due[i].patient);
+        }
+    }
+}
+void put_waitlist(const std::string &payload)
+{
+    json e = json::parse(payload);
+    if(e["op"] == "join") waiting.join(e["doctor"].get<std::string>(), e["date"], e["patient"].get<std::string>());
+    else waiting.leave(e["doctor"].get<std::string>(), e["date"], e["patient"].get<std::string>());
+}
+void publish_waitlist(const char *op, std::string_view doctor, int date, std::string_view patient)
+{
+    json e;
+    e["op"] = op, e["doctor"] = doctor, e["date"] = date, e["patient"] = patient;
+    event_bus.publish("waitlist", e.dump());
+}
+void load_waitlist()
+{
+    vvs v = execute_sql("SELECT `doctorUsername`, `date`, `patientUsername` FROM `waitlist` ORDER BY `id`");
+    int date;
+    if(!v.empty()) fcc(i, 1, v.size() - 1) if(parse_date(v[i][1], date)) waiting.join(v[i][0], date, v[i][2]);
+}
+// 把 (doctor, date) 空出来的号按候补顺序分出去, 每人占当天第一个空闲时段, 并给他发一条通知;
+// 候补记录由哪个 worker 删除成功就由哪个 worker 递补, 同一个人不会被两个 worker 各递补一次
+int promote_waitlist(std::string_view doctor, int date)
+{
+    doctor_rule rule;
+    int now = today(), count = 0;
+    if(date < now || !rules.get(doctor, rule)) return 0;
+    std::string day = date_text(date);
+    for(const std::string &patient : waiting.snapshot(doctor, date))
+    {
+        day_table::day *d = schedule.find(doctor, date, now, true);
+        if(!d || !day_table::try_book(*d, rule.limit)) break;
+        int slot = -1;
+        for(int s = (rule.begin + day_table::slot_seconds - 1) / day_table::slot_seconds;
+            slot < 0 && s < day_table::slots_per_day && (s + 1) * day_table::slot_seconds <= rule.end; ++s)
+            if(day_table::reserve(*d, s)) slot = s;
+        if(slot < 0)
+        {
+            day_table::cancel(*d);
+            break;
+        }
+        long long n = affected_sql(
+            "DELETE FROM `waitlist` WHERE " + par_format("patientUsername", patient) + " AND " +
+            par_format("doctorUsername", doctor) + " AND `date` = " + quote_sql(day));
+        publish_waitlist("leave", doctor, date, patient);
+        vvs cost = n == 1 ? execute_sql("SELECT `cost` FROM `doctorInfo` WHERE " + par_format("username", doctor)) : vvs();
+        if(cost.size() < 2)
+        {
+            day_table::cancel(*d), day_table::release(*d, slot);
+            continue;
+        }
+        std::string time = slot_text(slot);
+        record<s_appointment> a;
+        a.set(0, patient), a.set(1, doctor), a.set(2, day), a.set(3, time), a.set(4, cost[1][0]), a.set(5, "waiting");
+        if(insert_sql(a, ", `reminded` = 0") != "successful")
+        {
+            day_table::cancel(*d), day_table::release(*d, slot);
+            continue;
+        }
+        schedule_reminder(patient, doctor, date, slot * day_table::slot_seconds);
+        std::string message = "您候补的 " + std::string(doctor) + " 医生 " + day + " 的号已递补成功, 就诊时间 " + time;
+        std::string at = now_text();
+        record<s_notice> notice;
+        notice.set(0, patient), notice.set(1, "patient"), notice.set(2, message), notice.set(3, at);
+        insert_sql(notice);
+        publish_notice(patient);
+        ++count;
+    }
+    return count;
+}
+// 号源上限和出诊时间来自 doctorInfo, 已约人数和时段按今天及以后未取消的预约计;
+// 计数项已存在(其他 worker 先启动)时不重复累加
+void load_schedule()
+{
+    vvs v = execute_sql(select_sql<s_doctorInfo>());
+    if(!v.empty()) fcc(i, 1, v.size() - 1)
+    {
+        record<s_doctorInfo> r;
+        r.decode(v[i]);
+        rules.put(std::string(r.get<s_doctorInfo.index("username")>()), rule_of(r));
+    }
+    v = execute_sql(
+        "SELECT `doctorUsername`, `date`, `time` FROM `appointment` "
+        "WHERE `status` <> 'cancelled' AND `date` >= CURDATE()");
+    int now = today();
+    std::set<day_table::day*> fresh;
+    if(!v.empty()) fcc(i, 1, v.size() - 1)
     {
-        json k;
-        if(get_json(k, j, col[i - 1])) return "no [" + col[i - 1] + ']';
-        sql += par_format(k) + ", ";
+        int date, time;
+        bool created = false;
+        if(!parse_date(v[i][1], date) || !parse_time(v[i][2], time)) continue;
+        day_table::day *d = schedule.find(v[i][0], date, now, true, &created);
+        if(!d) continue;
+        if(created) fresh.insert(d);
+        if(!fresh.count(d)) continue;
+        d->booked.fetch_add(1);
+        if(time % day_table::slot_seconds == 0 && time / day_table::slot_seconds < day_table::slots_per_day)
+            day_table::reserve(*d, time / day_table::slot_seconds);
     }
-    sql.pop_back(), sql.pop_back(), sql += ") ON DUPLICATE KEY UPDATE";
-    fcc(i, 1, col.size()) sql += " `" + col[i - 1] + "` = VALUES(`" + col[i - 1] + "`),";
-    return sql.pop_back(), execute_sql(sql), "successful";
 }
 
-void handle_echo(tcp::socket &socket, json j) { reply_json(socket, j); }
-void handle_register(tcp::socket &socket, json j)
+void handle_echo(tcp::socket &socket, const json &j) { reply_json(socket, j); }
+void handle_ping(tcp::socket &socket, const json &) { reply_str(socket, reply_format("pong")); }
+void handle_register(tcp::socket &socket, const json &j)
 {
-    json username, type, password;
-    if(get_json(username, j, "username")) return reply_str(socket, reply_format("no [username]"));
-    if(get_json(type, j, "type")) return reply_str(socket, reply_format("no [type]"));
-    if(get_json(password, j, "password")) return reply_str(socket, reply_format("no [password]"));
+    std::string_view username, type, password;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(type, j, "type")) return reply_str(socket, reply_format(field_error(e, "type")));
+    if(int e = get_json(password, j, "password")) return reply_str(socket, reply_format(field_error(e, "password")));
     vvs v = execute_sql(
         "SELECT COUNT(*) FROM `account` WHERE " +
         par_format("username", username) + " AND " +
         par_format("type", type));
     if(v[1][0] != "0") return reply_str(socket, reply_format("failed"));
     std::string reverse(password);
-    std::reverse(reverse.begin(), reverse.end()), j["reverse"] = reverse;
-    insert_sql("account", vs_account, j);
+    std::reverse(reverse.begin(), reverse.end());
+    record<s_account> account;
+    account.set(0, username), account.set(1, type), account.set(2, reverse);
+    insert_sql(account);
     json init;
     if(type == "patient")
     {
@@ -148,7 +660,7 @@ void handle_register(tcp::socket &socket, json j)
         init["id"] = "110108195306151437";
         init["phoneNumber"] = "110";
         init["email"] = "bao@qingfeng.com";
-        insert_sql("patientInfo", vs_patientInfo, init);
+        if(insert_sql<s_patientInfo>(init) == "successful") publish_patient(username, "bao");
     }
     if(type == "doctor")
     {
@@ -160,16 +672,26 @@ void handle_register(tcp::socket &socket, json j)
         init["begin"] = "0";
         init["end"] = "24";
         init["limit"] = "201307";
-        insert_sql("doctorInfo", vs_doctorInfo, init);
+        if(insert_sql<s_doctorInfo>(init) == "successful") publish_doctor_rule(username, { 201307, 0, 24 * 3600 });
     }
     reply_str(socket, reply_format("successful"));
 }
-void handle_login(tcp::socket &socket, json j)
+// 128 位随机数的十六进制串
+std::string new_token()
+{
+    thread_local std::mt19937_64 gen(std::random_device{ }());
+    static const char hex[] = "0123456789abcdef";
+    std::string ret;
+    for(int i = 0; i < 2; ++i)
+        for(unsigned long long x = gen(), k = 0; k < 16; ++k, x >>= 4) ret += hex[x & 15];
+    return ret;
+}
+void handle_login(tcp::socket &socket, const json &j)
 {
-    json username, type, password;
-    if(get_json(username, j, "username")) return reply_str(socket, reply_format("no [username]"));
-    if(get_json(type, j, "type")) return reply_str(socket, reply_format("no [type]"));
-    if(get_json(password, j, "password")) return reply_str(socket, reply_format("no [password]"));
+    std::string_view username, type, password;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(type, j, "type")) return reply_str(socket, reply_format(field_error(e, "type")));
+    if(int e = get_json(password, j, "password")) return reply_str(socket, reply_format(field_error(e, "password")));
     vvs v = execute_sql(
         "SELECT COUNT(*) FROM `account` WHERE " +
         par_format("username", username) + " AND " +
@@ -183,51 +705,90 @@ void handle_login(tcp::socket &socket, json j)
         par_format("type", type) + " AND " +
         par_format("reverse", reverse));
     if(v[1][0] == "0") return reply_str(socket, reply_format("passwordWrong"));
-    reply_str(socket, reply_format("successful"));
+    // 会话令牌: 断线重连后凭它恢复会话, 不必重新登录
+    std::string token = new_token();
+    affected_sql("DELETE FROM `session` WHERE " + par_format("username", username) + " AND `expires` < NOW()");
+    if(affected_sql(
+        "INSERT INTO `session` (`token`, `username`, `type`, `expires`) VALUES (" + par_format(token) + ", " +
+        par_format(username) + ", " + par_format(type) + ", NOW() + INTERVAL " + int_to_str(session_ttl_hours) + " HOUR)") < 0)
+        return reply_str(socket, reply_format("failed"));
+    json ret;
+    ret["reply"] = "successful";
+    ret["data"]["token"] = token;
+    reply_json(socket, ret);
 }
-void handle_queryPatientInfo(tcp::socket &socket, json j)
+void handle_resume(tcp::socket &socket, const json &j)
 {
-    json patientUsername;
-    if(get_json(patientUsername, j, "patientUsername"))
-        return reply_str(socket, reply_format("no [patientUsername]"));
+    std::string_view token;
+    if(int e = get_json(token, j, "token")) return reply_str(socket, reply_format(field_error(e, "token")));
     vvs v = execute_sql(
-        "SELECT * FROM `patientInfo` WHERE " +
+        "SELECT `username`, `type` FROM `session` WHERE " + par_format("token", token) + " AND `expires` > NOW()");
+    if(v.size() < 2) return reply_str(socket, reply_format("expired"));
+    affected_sql(
+        "UPDATE `session` SET `expires` = NOW() + INTERVAL " + int_to_str(session_ttl_hours) + " HOUR WHERE " +
+        par_format("token", token));
+    json ret;
+    ret["reply"] = "successful";
+    ret["data"]["username"] = v[1][0];
+    ret["data"]["type"] = v[1][1];
+    reply_json(socket, ret);
+}
+void handle_queryPatientInfo(tcp::socket &socket, const json &j)
+{
+    std::string_view patientUsername;
+    if(int e = get_json(patientUsername, j, "patientUsername"))
+        return reply_str(socket, reply_format(field_error(e, "patientUsername")));
+    vvs v = execute_sql(
+        select_sql<s_patientInfo>() + " WHERE " +
         par_format("username", patientUsername));
     json ret;
     ret["data"]["patientInfo"];
     if(v.size() < 2) ret["reply"] = "failed";
-    else ret["reply"] = "successful", ret["data"]["patientInfo"] = vs_to_json(vs_patientInfo, v[1]);
+    else ret["reply"] = "successful", ret["data"]["patientInfo"] = row_to_json<s_patientInfo>(v[1]);
     reply_json(socket, ret);
 }
-void handle_modifyPatientInfo(tcp::socket &socket, json j)
+void handle_modifyPatientInfo(tcp::socket &socket, const json &j)
 {
-    json patientInfo;
-    if(get_json(patientInfo, j, "patientInfo"))
-        return reply_str(socket, reply_format("no [patientInfo]"));
-    reply_str(socket, reply_format(insert_sql("patientInfo", vs_patientInfo, patientInfo)));
+    const json *patientInfo;
+    if(int e = get_json(patientInfo, j, "patientInfo"))
+        return reply_str(socket, reply_format(field_error(e, "patientInfo")));
+    record<s_patientInfo> r;
+    std::string s = r.read(*patientInfo);
+    if(s.empty() && (s = insert_sql(r)) == "successful")
+        publish_patient(r.get<s_patientInfo.index("username")>(), r.get<s_patientInfo.index("name")>());
+    reply_str(socket, reply_format(s));
 }
-void handle_queryDoctorInfo(tcp::socket &socket, json j)
+void handle_queryDoctorInfo(tcp::socket &socket, const json &j)
 {
-    json doctorUsername;
-    if(get_json(doctorUsername, j, "doctorUsername"))
-        return reply_str(socket, reply_format("no [doctorUsername]"));
+    std::string_view doctorUsername;
+    if(int e = get_json(doctorUsername, j, "doctorUsername"))
+        return reply_str(socket, reply_format(field_error(e, "doctorUsername")));
     vvs v = execute_sql(
-        "SELECT * FROM `doctorInfo` WHERE " +
+        select_sql<s_doctorInfo>() + " WHERE " +
         par_format("username", doctorUsername));
     json ret;
     ret["data"]["doctorInfo"];
     if(v.size() < 2) ret["reply"] = "failed";
-    else ret["reply"] = "successful", ret["data"]["doctorInfo"] = vs_to_json(vs_doctorInfo, v[1]);
+    else ret["reply"] = "successful", ret["data"]["doctorInfo"] = row_to_json<s_doctorInfo>(v[1]);
     reply_json(socket, ret);
 }
-void handle_modifyDoctorInfo(tcp::socket &socket, json j)
+void handle_modifyDoctorInfo(tcp::socket &socket, const json &j)
 {
-    json doctorInfo;
-    if(get_json(doctorInfo, j, "doctorInfo"))
-        return reply_str(socket, reply_format("no [doctorInfo]"));
-    reply_str(socket, reply_format(insert_sql("doctorInfo", vs_doctorInfo, doctorInfo)));
+    const json *doctorInfo;
+    if(int e = get_json(doctorInfo, j, "doctorInfo"))
+        return reply_str(socket, reply_format(field_error(e, "doctorInfo")));
+    record<s_doctorInfo> r;
+    std::string s = r.read(*doctorInfo);
+    if(s.empty() && (s = insert_sql(r)) == "successful")
+    {
+        // 上限调高或出诊时间延长后可能放出新号
+        std::string_view doctor = r.get<s_doctorInfo.index("username")>();
+        publish_doctor_rule(doctor, rule_of(r));
+        for(int date : waiting.dates(doctor)) promote_waitlist(doctor, date);
+    }
+    reply_str(socket, reply_format(s));
 }
-void handle_queryPatientList(tcp::socket &socket, json j)
+void handle_queryPatientList(tcp::socket &socket, const json &)
 {
     vvs v = execute_sql(
         "SELECT a.username, p.name FROM account a "
@@ -236,133 +797,320 @@ void handle_queryPatientList(tcp::socket &socket, json j)
     json ret;
     ret["reply"] = "successful", ret["data"];
     if(!v.empty()) fcc(i, 1, v.size() - 1)
-        ret["data"]["patient_" + int_to_str(i)] = vs_to_json(vs_namelist, v[i]);
+        ret["data"]["patient_" + int_to_str(i)] = row_to_json<s_namelist>(v[i]);
+    reply_json(socket, ret);
+}
+void handle_searchPatients(tcp::socket &socket, const json &j)
+{
+    std::string_view prefix;
+    long long limit = search_limit;
+    if(int e = get_json(prefix, j, "prefix")) return reply_str(socket, reply_format(field_error(e, "prefix")));
+    if(get_json(limit, j, "limit") == 2 || limit < 1) return reply_str(socket, reply_format("bad [limit]"));
+    auto hits = patients.search(prefix, std::min<long long>(limit, max_search_limit));
+    json ret;
+    ret["reply"] = "successful", ret["data"];
+    fcc(i, 1, hits.size())
+        ret["data"]["patient_" + int_to_str(i)] = { { "username", hits[i - 1].first }, { "name", hits[i - 1].second } };
     reply_json(socket, ret);
 }
-void handle_queryDoctorList(tcp::socket &socket, json j)
+void handle_queryDoctorList(tcp::socket &socket, const json &j)
 {
-    json Time;
-    if(get_json(Time, j, "time")) return reply_str(socket, reply_format("no [time]"));
-    int t = str_to_int(Time), cou = 0;
-    vvs v = execute_sql("SELECT * FROM `doctorInfo`");
+    long long t;
+    if(int e = get_json(t, j, "time")) return reply_str(socket, reply_format(field_error(e, "time")));
+    int cou = 0;
+    vvs v = execute_sql(select_sql<s_doctorInfo>());
     json ret;
     ret["reply"] = "successful", ret["data"];
     if(!v.empty()) fcc(i, 1, v.size() - 1)
     {
-        json k = vs_to_json(vs_doctorInfo, v[i]);
-        int b = str_to_int(k["begin"]), e = str_to_int(k["end"]);
-        if(t == 25 || (b <= t && t <= e)) ret["data"]["doctor_" + int_to_str(++cou)] = k;
+        record<s_doctorInfo> k;
+        k.decode(v[i]);
+        int b = k.get<s_doctorInfo.index("begin")>() / 3600, e = k.get<s_doctorInfo.index("end")>() / 3600;
+        if(t == 25 || (b <= t && t <= e)) ret["data"]["doctor_" + int_to_str(++cou)] = k.to_json();
     }
     reply_json(socket, ret);
 }
-void handle_queryAppointmentList(tcp::socket &socket, json j)
+void handle_queryAppointmentList(tcp::socket &socket, const json &j)
 {
-    json username, type;
-    if(get_json(username, j, "username")) return reply_str(socket, reply_format("no [username]"));
-    if(get_json(type, j, "type")) return reply_str(socket, reply_format("no [type]"));
+    std::string_view username, type;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(type, j, "type")) return reply_str(socket, reply_format(field_error(e, "type")));
+    if(type != "patient" && type != "doctor") return reply_str(socket, reply_format("bad [type]"));
     vvs v = execute_sql(
-        "SELECT * FROM `appointment` WHERE " +
+        select_sql<s_appointment>() + " WHERE " +
         par_format(std::string(type) + "Username", username));
     json ret;
     ret["reply"] = "successful", ret["data"];
     if(!v.empty()) fcc(i, 1, v.size() - 1)
-        ret["data"]["appointment_" + int_to_str(i)] = vs_to_json(vs_appointment, v[i]);
+        ret["data"]["appointment_" + int_to_str(i)] = row_to_json<s_appointment>(v[i]);
     reply_json(socket, ret);
 }
-void handle_modifyAppointment(tcp::socket &socket, json j)
-{
-    json appointment;
-    if(get_json(appointment, j, "appointment"))
-        return reply_str(socket, reply_format("no [appointment]"));
-    appointment["cost"] = execute_sql(
-        "SELECT `cost` FROM `doctorInfo` WHERE " +
-        par_format("username", appointment["doctorUsername"]))[1][0];
-    json Case, advice;
-    fcc(i, 0, 3) Case[vs_case[i]] = advice[vs_advice[i]] = appointment[vs_appointment[i]];
-    fcc(i, 4, vs_case.size() - 1) Case[vs_case[i]] = "unknown";
-    fcc(i, 4, vs_advice.size() - 1) advice[vs_advice[i]] = "unknown";
-    insert_sql("case", vs_case, Case), insert_sql("advice", vs_advice, advice);
-    reply_str(socket, reply_format(insert_sql("appointment", vs_appointment, appointment)));
-}
-void handle_queryCaseList(tcp::socket &socket, json j)
-{
-    json username, type;
-    if(get_json(username, j, "username")) return reply_str(socket, reply_format("no [username]"));
-    if(get_json(type, j, "type")) return reply_str(socket, reply_format("no [type]"));
-    vvs v = execute_sql(
-        "SELECT * FROM `case` WHERE " +
-        par_format(std::string(type) + "Username", username));
+void handle_modifyAppointment(tcp::socket &socket, const json &j)
+{
+    const json *appointment;
+    if(int e = get_json(appointment, j, "appointment"))
+        return reply_str(socket, reply_format(field_error(e, "appointment")));
+    record<s_appointment> a;
+    a.set(s_appointment.index("cost"), "0");  // 费用以医生信息为准, 放号检查通过后再查
+    std::string error = a.read(*appointment);
+    if(!error.empty()) return reply_str(socket, reply_format(error));
+    std::string_view doctorUsername = a.get<s_appointment.index("doctorUsername")>();
+    std::string_view status = a.get<s_appointment.index("status")>();
+    int date = a.get<s_appointment.index("date")>(), time = a.get<s_appointment.index("time")>();
+    int slot = time / day_table::slot_seconds, now = today();
+    doctor_rule rule;
+    if(!rules.get(doctorUsername, rule)) return reply_str(socket, reply_format("failed"));
+    // 取消: 只有确实从未取消变为取消的那一次才归还号源
+    if(status == "cancelled")
+    {
+        day_table::day *d = schedule.find(doctorUsername, date, now, false);
+        long long n = affected_sql(
+            "UPDATE `appointment` SET `status` = 'cancelled' WHERE " +
+            par_format("patientUsername", a.get<s_appointment.index("patientUsername")>()) + " AND " +
+            par_format("doctorUsername", doctorUsername) + " AND " +
+            "`date` = " + a.literal(s_appointment.index("date")) + " AND " +
+            "`time` = " + a.literal(s_appointment.index("time")) + " AND `status` <> 'cancelled'");
+        if(n > 0)
+        {
+            json row = a.to_json();
+            row.erase("cost");  // 取消时不知道原费用, 只推键和新状态
+            publish_change(s_appointment.name, "update", std::move(row));
+        }
+        if(n > 0 && d)
+        {
+            day_table::cancel(*d);
+            if(slot < day_table::slots_per_day) day_table::release(*d, slot);
+            promote_waitlist(doctorUsername, date);
+        }
+        return reply_str(socket, reply_format(n > 0 ? "successful" : "failed"));
+    }
+    // 新预约先在内存里占号再占时段, 满了或时段已被占直接拒绝, 不碰数据库
+    day_table::day *d = 0;
+    if(status == "waiting" || status == "pending")
+    {
+        if(date < now) return reply_str(socket, reply_format("bad [date]"));
+        if(time % day_table::slot_seconds || time < rule.begin || time + day_table::slot_seconds > rule.end)
+            return reply_str(socket, reply_format("bad [time]"));
+        d = schedule.find(doctorUsername, date, now, true);
+        if(!d) return reply_str(socket, reply_format("failed"));
+        if(!day_table::try_book(*d, rule.limit)) return reply_str(socket, reply_format("full"));
+        if(!day_table::reserve(*d, slot)) return day_table::cancel(*d), reply_str(socket, reply_format("occupied"));
+    }
+    vvs cost = execute_sql("SELECT `cost` FROM `doctorInfo` WHERE " + par_format("username", doctorUsername));
+    if(cost.size() < 2)
+    {
+        if(d) day_table::cancel(*d), day_table::release(*d, slot);
+        return reply_str(socket, reply_format("failed"));
+    }
+    a.set(s_appointment.index("cost"), cost[1][0]);
+    // 同一时段以前约过又取消的, 唯一键会落到那条旧记录上: upsert 把它改回新状态, 并重新等待提醒
+    std::string s = insert_sql(a, d ? ", `reminded` = 0" : "");
+    if(s != "successful")
+    {
+        if(d) day_table::cancel(*d), day_table::release(*d, slot);
+        return reply_str(socket, reply_format(s));
+    }
+    record<s_case> Case;
+    record<s_advice> advice;
+    fcc(i, 0, 3) Case.set(i, a.text(i)), advice.set(i, a.text(i));
+    fcc(i, 4, s_case.size() - 1) Case.set(i, "unknown");
+    fcc(i, 4, s_advice.size() - 1) advice.set(i, "unknown");
+    insert_indexed(Case), insert_indexed(advice);
+    if(d) schedule_reminder(a.get<s_appointment.index("patientUsername")>(), doctorUsername, date, time);
+    reply_str(socket, reply_format(s));
+}
+// 医生某天约满时排队候补, 有号空出时自动递补并收到通知
+void handle_joinWaitlist(tcp::socket &socket, const json &j)
+{
+    std::string_view patientUsername, doctorUsername, Date;
+    int date;
+    if(int e = get_json(patientUsername, j, "patientUsername"))
+        return reply_str(socket, reply_format(field_error(e, "patientUsername")));
+    if(int e = get_json(doctorUsername, j, "doctorUsername"))
+        return reply_str(socket, reply_format(field_error(e, "doctorUsername")));
+    if(int e = get_json(Date, j, "date")) return reply_str(socket, reply_format(field_error(e, "date")));
+    if(!parse_date(Date, date) || date < today()) return reply_str(socket, reply_format("bad [date]"));
+    affected_sql(
+        "INSERT IGNORE INTO `waitlist` (`patientUsername`, `doctorUsername`, `date`) VALUES (" +
+        par_format(patientUsername) + ", " + par_format(doctorUsername) + ", " + quote_sql(date_text(date)) + ")");
+    publish_waitlist("join", doctorUsername, date, patientUsername);
+    // 加入时恰好已有空号(比如刚有人取消)就立即递补
+    promote_waitlist(doctorUsername, date);
+    std::vector<std::string> q = waiting.snapshot(doctorUsername, date);
+    auto it = std::find(q.begin(), q.end(), patientUsername);
+    json ret;
+    ret["reply"] = "successful";
+    ret["data"]["position"] = it == q.end() ? 0 : int(it - q.begin()) + 1;  // 0 表示已递补
+    reply_json(socket, ret);
+}
+void handle_exitWaitlist(tcp::socket &socket, const json &j)
+{
+    std::string_view patientUsername, doctorUsername, Date;
+    int date;
+    if(int e = get_json(patientUsername, j, "patientUsername"))
+        return reply_str(socket, reply_format(field_error(e, "patientUsername")));
+    if(int e = get_json(doctorUsername, j, "doctorUsername"))
+        return reply_str(socket, reply_format(field_error(e, "doctorUsername")));
+    if(int e = get_json(Date, j, "date")) return reply_str(socket, reply_format(field_error(e, "date")));
+    if(!parse_date(Date, date)) return reply_str(socket, reply_format("bad [date]"));
+    long long n = affected_sql(
+        "DELETE FROM `waitlist` WHERE " + par_format("patientUsername", patientUsername) + " AND " +
+        par_format("doctorUsername", doctorUsername) + " AND `date` = " + quote_sql(date_text(date)));
+    publish_waitlist("leave", doctorUsername, date, patientUsername);
+    reply_str(socket, reply_format(n > 0 ? "successful" : "failed"));
+}
+// 某医生某天还能约的时段("HH:MM"), 当天已约满时为空
+void handle_queryFreeSlots(tcp::socket &socket, const json &j)
+{
+    std::string_view doctorUsername, Date;
+    int date, now = today();
+    doctor_rule rule;
+    if(int e = get_json(doctorUsername, j, "doctorUsername"))
+        return reply_str(socket, reply_format(field_error(e, "doctorUsername")));
+    if(int e = get_json(Date, j, "date")) return reply_str(socket, reply_format(field_error(e, "date")));
+    if(!parse_date(Date, date)) return reply_str(socket, reply_format("bad [date]"));
+    if(!rules.get(doctorUsername, rule)) return reply_str(socket, reply_format("failed"));
+    day_table::day *d = schedule.find(doctorUsername, date, now, false);
+    json ret;
+    ret["reply"] = "successful", ret["data"]["slots"] = json::array();
+    if(date >= now && (!d || d->booked.load() < rule.limit))
+        for(int s = (rule.begin + day_table::slot_seconds - 1) / day_table::slot_seconds;
+            s < day_table::slots_per_day && (s + 1) * day_table::slot_seconds <= rule.end; ++s)
+            if(!d || !day_table::is_taken(*d, s)) ret["data"]["slots"].push_back(slot_text(s));
+    reply_json(socket, ret);
+}
+// 某用户的病历/医嘱. 带上次回复的 watermark 作 since 时只返回之后改过的行, 客户端按 id 合并进本地库;
+// 并发事务的提交顺序和 `updated` 的先后不一定一致, 因此往前多取 sync_overlap_seconds 秒, 重复的行由客户端去重
+template<const auto &S>
+void query_records(tcp::socket &socket, const json &j, const std::string &prefix)
+{
+    std::string_view username, type, since;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(type, j, "type")) return reply_str(socket, reply_format(field_error(e, "type")));
+    if(type != "patient" && type != "doctor") return reply_str(socket, reply_format("bad [type]"));
+    if(get_json(since, j, "since") == 2 || !is_watermark(since))
+        return reply_str(socket, reply_format("bad [since]"));
+    std::string sql = "SELECT `id`, `updated`, " + column_list<S>() + " FROM `" + S.name + "` WHERE " +
+                      par_format(std::string(type) + "Username", username);
+    if(!since.empty())
+        sql += " AND `updated` > " + quote_sql(since) + " - INTERVAL " + int_to_str(sync_overlap_seconds) + " SECOND";
+    vvs v = execute_sql(sql + " ORDER BY `updated`");
+    std::string watermark(since);
     json ret;
     ret["reply"] = "successful", ret["data"];
     if(!v.empty()) fcc(i, 1, v.size() - 1)
-        ret["data"]["case_" + int_to_str(i)] = vs_to_json(vs_case, v[i]);
+    {
+        json k = row_to_json<S>(std::vector<std::string>(v[i].begin() + 2, v[i].end()));
+        k["id"] = std::stoll(v[i][0]);
+        ret["data"][prefix + int_to_str(i)] = std::move(k);
+        max_(watermark, v[i][1]);
+    }
+    ret["data"]["watermark"] = watermark;
     reply_json(socket, ret);
 }
-void handle_modifyCase(tcp::socket &socket, json j)
+void handle_queryCaseList(tcp::socket &socket, const json &j) { query_records<s_case>(socket, j, "case_"); }
+void handle_modifyCase(tcp::socket &socket, const json &j)
 {
-    json Case;
-    if(get_json(Case, j, "case")) return reply_str(socket, reply_format("no [case]"));
-    reply_str(socket, reply_format(insert_sql("case", vs_case, Case)));
+    const json *Case;
+    if(int e = get_json(Case, j, "case")) return reply_str(socket, reply_format(field_error(e, "case")));
+    record<s_case> r;
+    std::string s = r.read(*Case);
+    reply_str(socket, reply_format(s.empty() ? insert_indexed(r) : s));
 }
-void handle_queryAdviceList(tcp::socket &socket, json j)
+void handle_searchCases(tcp::socket &socket, const json &j)
 {
-    json username, type;
-    if(get_json(username, j, "username")) return reply_str(socket, reply_format("no [username]"));
-    if(get_json(type, j, "type")) return reply_str(socket, reply_format("no [type]"));
-    vvs v = execute_sql(
-        "SELECT * FROM `advice` WHERE " +
-        par_format(std::string(type) + "Username", username));
+    std::string_view username, type, keyword;
+    long long limit = search_limit;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(type, j, "type")) return reply_str(socket, reply_format(field_error(e, "type")));
+    if(int e = get_json(keyword, j, "keyword")) return reply_str(socket, reply_format(field_error(e, "keyword")));
+    if(type != "patient" && type != "doctor") return reply_str(socket, reply_format("bad [type]"));
+    if(get_json(limit, j, "limit") == 2 || limit < 1) return reply_str(socket, reply_format("bad [limit]"));
+    auto hits = search_index.search(keyword, type == "doctor", username, std::min<long long>(limit, max_search_limit));
     json ret;
     ret["reply"] = "successful", ret["data"];
-    if(!v.empty()) fcc(i, 1, v.size() - 1)
-        ret["data"]["advice_" + int_to_str(i)] = vs_to_json(vs_advice, v[i]);
+    fcc(i, 1, hits.size()) ret["data"]["result_" + int_to_str(i)] = std::move(hits[i - 1]);
     reply_json(socket, ret);
 }
-void handle_modifyAdvice(tcp::socket &socket, json j)
+void handle_queryAdviceList(tcp::socket &socket, const json &j) { query_records<s_advice>(socket, j, "advice_"); }
+void handle_modifyAdvice(tcp::socket &socket, const json &j)
 {
-    json advice;
-    if(get_json(advice, j, "advice")) return reply_str(socket, reply_format("no [advice]"));
-    reply_str(socket, reply_format(insert_sql("advice", vs_advice, advice)));
+    const json *advice;
+    if(int e = get_json(advice, j, "advice")) return reply_str(socket, reply_format(field_error(e, "advice")));
+    record<s_advice> r;
+    std::string s = r.read(*advice);
+    reply_str(socket, reply_format(s.empty() ? insert_indexed(r) : s));
 }
-void handle_queryNoticeList(tcp::socket &socket, json j)
+void handle_queryNoticeList(tcp::socket &socket, const json &j)
 {
-    json username, type;
-    if(get_json(username, j, "username")) return reply_str(socket, reply_format("no [username]"));
-    if(get_json(type, j, "type")) return reply_str(socket, reply_format("no [type]"));
+    std::string_view username, type;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(type, j, "type")) return reply_str(socket, reply_format(field_error(e, "type")));
     vvs v = execute_sql(
-        "SELECT * FROM `notice` WHERE " +
+        select_sql<s_notice>() + " WHERE " +
         par_format("type", "admin") + " OR (" +
         par_format("username", username) + " AND " + par_format("type", type) + ")");
     json ret;
     ret["reply"] = "successful", ret["data"];
     if(!v.empty()) fcc(i, 1, v.size() - 1)
-        ret["data"]["notice_" + int_to_str(i)] = vs_to_json(vs_notice, v[i]);
+        ret["data"]["notice_" + int_to_str(i)] = row_to_json<s_notice>(v[i]);
     reply_json(socket, ret);
 }
-void handle_modifyNotice(tcp::socket &socket, json j)
+void handle_modifyNotice(tcp::socket &socket, const json &j)
 {
-    json notice;
-    if(get_json(notice, j, "notice")) return reply_str(socket, reply_format("no [notice]"));
-    reply_str(socket, reply_format(insert_sql("notice", vs_notice, notice)));
+    const json *notice;
+    if(int e = get_json(notice, j, "notice")) return reply_str(socket, reply_format(field_error(e, "notice")));
+    record<s_notice> r;
+    std::string s = r.read(*notice);
+    if(s.empty()) s = insert_sql(r);
+    if(s == "successful") publish_notice(r.text(s_notice.index("type")) == "admin" ? "" : r.text(s_notice.index("username")));
+    reply_str(socket, reply_format(s));
 }
-void handle_clock(tcp::socket &socket, json j)
+// 订阅后本连接会收到 {"reply":"notice"} 推送; 先补推已读游标之后的通知, 离线期间的通知不会丢
+void handle_subscribeNotice(tcp::socket &socket, const json &j)
 {
-    j["status"] = "clock";
-    reply_str(socket, reply_format(insert_sql("work", vs_work, j)));
+    std::string_view username, type;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(type, j, "type")) return reply_str(socket, reply_format(field_error(e, "type")));
+    vvs v = execute_sql("SELECT `lastId` FROM `noticeCursor` WHERE " + par_format("username", username));
+    notice_subs.subscribe(&socket, username, type, v.size() < 2 ? 0 : std::stoll(v[1][0]));
+    reply_str(socket, reply_format("successful"));
+    if(auto s = notice_subs.find(&socket)) push_notices(*s);
 }
-void handle_leave(tcp::socket &socket, json j)
+// 客户端确认已收到 id 及以前的通知, 游标只前进不后退
+void handle_ackNotice(tcp::socket &socket, const json &j)
 {
-    j["status"] = "leave";
-    reply_str(socket, reply_format(insert_sql("work", vs_work, j)));
+    std::string_view username;
+    long long id;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(id, j, "id")) return reply_str(socket, reply_format(field_error(e, "id")));
+    long long n = affected_sql(
+        "INSERT INTO `noticeCursor` (`username`, `lastId`) VALUES (" + par_format(username) + ", " +
+        std::to_string(id) + ") ON DUPLICATE KEY UPDATE `lastId` = GREATEST(`lastId`, VALUES(`lastId`))");
+    reply_str(socket, reply_format(n < 0 ? "failed" : "successful"));
 }
-int judge_question(json q)
+void handle_clock(tcp::socket &socket, const json &j)
+{
+    record<s_work> r;
+    r.set(s_work.index("status"), "clock");
+    std::string error = r.read(j);
+    reply_str(socket, reply_format(error.empty() ? queue_sql(r) : error));
+}
+void handle_leave(tcp::socket &socket, const json &j)
+{
+    record<s_work> r;
+    r.set(s_work.index("status"), "leave");
+    std::string error = r.read(j);
+    reply_str(socket, reply_format(error.empty() ? queue_sql(r) : error));
+}
+int judge_question(const record<s_question> &q)
 {
     int ret = 0;
-    int height = str_to_int(q["height"]);
-    int weight = str_to_int(q["weight"]);
-    int heart = str_to_int(q["heart"]);
-    int pressure = str_to_int(q["pressure"]);
-    int lung = str_to_int(q["lung"]);
+    double height = q.get<s_question.index("height")>();
+    double weight = q.get<s_question.index("weight")>();
+    long long heart = q.get<s_question.index("heart")>();
+    long long pressure = q.get<s_question.index("pressure")>();
+    long long lung = q.get<s_question.index("lung")>();
     if(100 <= height && height <= 300) ret |= 1;
     if(30 <= weight && weight <= 130) ret |= 2;
     if(50 <= heart && heart <= 250) ret |= 4;
@@ -370,37 +1118,43 @@ int judge_question(json q)
     if(1000 <= lung && lung <= 9999) ret |= 16;
     return ret;
 }
-void handle_modifyQuestion(tcp::socket &socket, json j)
+void handle_modifyQuestion(tcp::socket &socket, const json &j)
 {
-    json question;
-    if(get_json(question, j, "question")) return reply_str(socket, reply_format("no [question]"));
-    std::string s = insert_sql("question", vs_question, question);
+    const json *question;
+    if(int e = get_json(question, j, "question")) return reply_str(socket, reply_format(field_error(e, "question")));
+    record<s_question> q;
+    std::string s = q.read(*question);
+    if(s.empty()) s = queue_sql(q);
     json ret;
     ret["reply"] = s, ret["data"]["result"];
-    if(s[0] != 'n' || s[1] != 'o')
+    if(s == "successful")
     {
-        int jq = judge_question(question);
+        int jq = judge_question(q);
         std::string r;
         fcc(i, 0, 4) r += (jq >> i & 1 ? "N" : "Abn")
-            + std::string("ormal ") + vs_question[i + 3] + ".;";
+            + std::string("ormal ") + s_question.col[i + 3].name + ".;";
         ret["data"]["result"] = r;
     }
     reply_json(socket, ret);
 }
 constexpr int days[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-void handle_queryAttendance(tcp::socket &socket, json j)
+void handle_queryAttendance(tcp::socket &socket, const json &j)
 {
-    json username, month;
-    if(get_json(username, j, "username")) return reply_str(socket, reply_format("no [username]"));
-    if(get_json(month, j, "month")) return reply_str(socket, reply_format("no [month]"));
-    int mon = str_to_int(month), clock = 0, leave = 0;
-    vvs v = execute_sql("SELECT * FROM `work` WHERE " + par_format("username", username));
+    std::string_view username;
+    long long mon;
+    int clock = 0, leave = 0;
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(int e = get_json(mon, j, "month")) return reply_str(socket, reply_format(field_error(e, "month")));
+    if(mon < 1 || mon > 12) return reply_str(socket, reply_format("bad [month]"));
+    vvs v = execute_sql(select_sql<s_work>() + " WHERE " + par_format("username", username));
     std::map<int, int> mp;
     if(!v.empty()) fcc(i, 1, v.size() - 1)
     {
-        json k = vs_to_json(vs_work, v[i]);
-        int date = str_to_int(k["date"]);
-        if(date / 100 % 100 == mon) max_(mp[date % 100], k["status"] == "clock" ? 2 : 1);
+        record<s_work> k;
+        k.decode(v[i]);
+        int date = k.get<s_work.index("date")>();
+        if(date / 100 % 100 == mon)
+            max_(mp[date % 100], k.get<s_work.index("status")>() == "clock" ? 2 : 1);
     }
     fcc(i, 1, days[mon])
         if(mp[i] == 2) ++clock;
@@ -413,81 +1167,132 @@ void handle_queryAttendance(tcp::socket &socket, json j)
         "absence " + int_to_str(days[mon] - clock - leave) + " day(s);";
     reply_json(socket, ret);
 }
-void handle_queryChart(tcp::socket &socket, json j)
+void handle_queryChart(tcp::socket &socket, const json &)
 {
     int tot = 0, cou[5] = { };
-    vvs v = execute_sql("SELECT * FROM `question`");
+    vvs v = execute_sql(select_sql<s_question>());
     if(!v.empty()) fcc(i, 1, v.size() - 1)
     {
-        json k = vs_to_json(vs_question, v[i]);
+        record<s_question> k;
+        k.decode(v[i]);
         int jq = judge_question(k);
         ++tot;
         fcc(i, 0, 4) if(!(jq >> i & 1)) ++cou[i];
     }
     std::string s = "Total: " + int_to_str(tot) + ".;";
-    fcc(i, 0, 4) s += "Abnormal " + vs_question[i + 3] + ": " + int_to_str(cou[i]) + ".;";
+    fcc(i, 0, 4) s += "Abnormal " + std::string(s_question.col[i + 3].name) + ": " + int_to_str(cou[i]) + ".;";
     json ret;
     ret["reply"] = "successful", ret["data"]["chart"] = s;
     reply_json(socket, ret);
 }
-void handle_chat(tcp::socket &socket, json j)
+void broadcast_chat(const std::string &message)
+{
+    std::vector<std::shared_ptr<outbox::peer>> to;
+    {
+        std::lock_guard<std::mutex> lock(chat_mutex);
+        for(auto s : chat_socket) std::cout << "# " << s << newl;
+        for(auto s : chat_socket) if(auto p = outbound.find(s)) to.push_back(std::move(p));
+    }
+    for(auto &p : to) outbound.push(p, message + newl);
+}
+void handle_chat(tcp::socket &, const json &j)
 {
+    std::string_view username, message;
+    if(get_json(username, j, "username") || get_json(message, j, "message")) return;
     json ret;
     ret["reply"] = "successful";
-    ret["data"]["message"] = '[' + std::string(j["username"]) + "] " + std::string(j["message"]);
-    for(auto s : chat_socket) std::cout << "# " << s << newl;
-    for(auto s : chat_socket) reply_json(*s, ret);
+    ret["data"]["message"] = '[' + std::string(username) + "] " + std::string(message);
+    event_bus.publish("chat", ret.dump());
 }
-void handle_joinChat(tcp::socket &socket, json j)
+void handle_joinChat(tcp::socket &socket, const json &)
 {
     std::cout << "+ " << &socket << newl;
-    chat_socket.insert(&socket);
+    {
+        std::lock_guard<std::mutex> lock(chat_mutex);
+        chat_socket.insert(&socket);
+    }
+    reply_str(socket, reply_format("successful"));
+}
+void handle_exitChat(tcp::socket &socket, const json &)
+{
+    {
+        std::lock_guard<std::mutex> lock(chat_mutex);
+        chat_socket.erase(&socket);
+    }
+    reply_str(socket, reply_format("successful"));
+}
+// 订阅 appointment/case/advice 中患者或医生为 username 的行, 之后每次写入推送 {"reply":"change"}
+void handle_subscribe(tcp::socket &socket, const json &j)
+{
+    std::string_view entity, username;
+    if(int e = get_json(entity, j, "entity")) return reply_str(socket, reply_format(field_error(e, "entity")));
+    if(int e = get_json(username, j, "username")) return reply_str(socket, reply_format(field_error(e, "username")));
+    if(entity != s_appointment.name && entity != s_case.name && entity != s_advice.name)
+        return reply_str(socket, reply_format("bad [entity]"));
+    feeds.subscribe(&socket, entity, username);
     reply_str(socket, reply_format("successful"));
 }
-void handle_exitChat(tcp::socket &socket, json j)
+void handle_unsubscribe(tcp::socket &socket, const json &j)
 {
-    chat_socket.erase(&socket);
+    std::string_view entity;
+    if(int e = get_json(entity, j, "entity"); e == 2) return reply_str(socket, reply_format(field_error(e, "entity")));
+    feeds.unsubscribe(&socket, entity);
     reply_str(socket, reply_format("successful"));
 }
-void handle_modifyadminInfoClient(tcp::socket &socket, json j)
+void handle_modifyadminInfoClient(tcp::socket &socket, const json &j)
 {
     if(j.contains("patientInfo")) handle_modifyPatientInfo(socket, j);
     else handle_modifyDoctorInfo(socket, j);
 }
-int handle(tcp::socket &socket)
+// 处理一条请求; 带 id 的请求, 回复里原样带回这个 id
+void dispatch(tcp::socket &socket, const std::string &frame)
 {
-    char buf[1 << 16];
-    boost::system::error_code ec;
-    int length = socket.read_some(boost::asio::buffer(buf), ec);
-    std::string str;
-    fcc(i, 0, length - 1) if(buf[i] != ' ' && buf[i] != '\n') str += buf[i];
-    std::cout << "--> " << str << newl, std::cout.flush();
-    if(ec) return 1;
     json receive;
-    try { receive = json::parse(str); }
-    catch(const std::exception &e) { return reply_str(socket, reply_format("jsonError")), 0; }
-    json command, data;
-    if(get_json(command, receive, "command"))
-        return reply_str(socket, reply_format("no [command]")), 0;
-    if(get_json(data, receive, "data"))
-        return reply_str(socket, reply_format("no [data]")), 0;
+    int error = parse_frame(frame, receive);
+    if(error == 1) return;
+    std::cout << "--> " << frame << newl, std::cout.flush();
+    if(error == 2) return reply_str(socket, reply_format("jsonError"));
+    request_socket = 0;
+    if(receive.is_object() && receive.contains("id") && receive["id"].is_primitive())
+        request_socket = &socket, request_id = receive["id"].dump(), receive.erase("id");
+    version_socket = 0;
+    if(receive.is_object() && receive.contains("version") && receive["version"].is_string())
+        version_socket = &socket, request_version = receive["version"], receive.erase("version");
+    std::string_view command;
+    const json *p;
+    if(int e = get_json(command, receive, "command"))
+        return reply_str(socket, reply_format(field_error(e, "command")));
+    if(get_json(p, receive, "data"))
+        return reply_str(socket, reply_format("no [data]"));
+    const json &data = *p;
+    admission_guard guard(gate, classify_command(command));
+    if(!guard.admitted()) return reply_str(socket, reply_format("busy"));
     if(command == "echo") handle_echo(socket, receive);
+    if(command == "ping") handle_ping(socket, data);
     if(command == "register") handle_register(socket, data);
     if(command == "login") handle_login(socket, data);
+    if(command == "resume") handle_resume(socket, data);
     if(command == "queryPatientInfo") handle_queryPatientInfo(socket, data);
     if(command == "modifyPatientInfo") handle_modifyPatientInfo(socket, data);
     if(command == "queryDoctorInfo") handle_queryDoctorInfo(socket, data);
     if(command == "modifyDoctorInfo") handle_modifyDoctorInfo(socket, data);
     if(command == "queryPatientList") handle_queryPatientList(socket, data);
+    if(command == "searchPatients") handle_searchPatients(socket, data);
     if(command == "queryDoctorList") handle_queryDoctorList(socket, data);
     if(command == "queryAppointmentList") handle_queryAppointmentList(socket, data);
     if(command == "modifyAppointment") handle_modifyAppointment(socket, data);
+    if(command == "queryFreeSlots") handle_queryFreeSlots(socket, data);
+    if(command == "joinWaitlist") handle_joinWaitlist(socket, data);
+    if(command == "exitWaitlist") handle_exitWaitlist(socket, data);
     if(command == "queryCaseList") handle_queryCaseList(socket, data);
     if(command == "modifyCase") handle_modifyCase(socket, data);
+    if(command == "searchCases") handle_searchCases(socket, data);
     if(command == "queryAdviceList") handle_queryAdviceList(socket, data);
     if(command == "modifyAdvice") handle_modifyAdvice(socket, data);
     if(command == "queryNoticeList") handle_queryNoticeList(socket, data);
     if(command == "modifyNotice") handle_modifyNotice(socket, data);
+    if(command == "subscribeNotice") handle_subscribeNotice(socket, data);
+    if(command == "ackNotice") handle_ackNotice(socket, data);
     if(command == "clock") handle_clock(socket, data);
     if(command == "leave") handle_leave(socket, data);
     if(command == "modifyQuestion") handle_modifyQuestion(socket, data);
@@ -496,7 +1301,27 @@ int handle(tcp::socket &socket)
     if(command == "chat") handle_chat(socket, data);
     if(command == "joinChat") handle_joinChat(socket, data);
     if(command == "exitChat") handle_exitChat(socket, data);
+    if(command == "subscribe") handle_subscribe(socket, data);
+    if(command == "unsubscribe") handle_unsubscribe(socket, data);
     if(command == "modifyadminInfoClient") handle_modifyadminInfoClient(socket, data);
+    request_socket = 0, version_socket = 0;
+}
+// 读一次, 按 '\n' 切出完整的请求逐条处理, 客户端可以连发多条请求不等回复;
+// 不带换行的旧客户端每次发一条完整的 JSON, 剩下的部分本身能解析时也直接处理
+int handle(tcp::socket &socket, std::string &pending)
+{
+    char buf[1 << 16];
+    boost::system::error_code ec;
+    int length = socket.read_some(boost::asio::buffer(buf), ec);
+    if(ec) return 1;
+    idle_reaper.touch(&socket);
+    pending.append(buf, length);
+    size_t begin = 0;
+    for(size_t end; (end = pending.find('\n', begin)) != std::string::npos; begin = end + 1)
+        dispatch(socket, pending.substr(begin, end - begin));
+    pending.erase(0, begin);
+    if(!pending.empty() && json::accept(pending)) dispatch(socket, pending), pending.clear();
+    else if(pending.size() > max_request) pending.clear(), reply_str(socket, reply_format("jsonError"));
     return 0;
 }
 void handle_client(tcp::socket *socket)
@@ -505,24 +1330,59 @@ void handle_client(tcp::socket *socket)
     try { ip = socket->remote_endpoint().address().to_string(); }
     catch(const std::exception &e) { }
     std::cout << '[' << ip << ']' << " Client connected" << newl;
+    idle_reaper.add(socket);
+    outbound.add(socket);
     reply_str(*socket, reply_format("successful_connection"));
-    for(; !handle(*socket););
+    std::string pending;
+    for(; !handle(*socket, pending););
     std::cout << '[' << ip << ']' << " Client disconnected" << newl;
+    idle_reaper.remove(socket);
     handle_exitChat(*socket, { });
+    notice_subs.unsubscribe(socket);
+    feeds.unsubscribe(socket);
+    outbound.close(socket);
     delete socket;
 }
 int main()
 {
+    pid_t master = getpid();
+    int workers = worker_count(), worker = workers > 1 ? spawn_workers(workers) : 0;
     // mysql -h 120.46.180.76 -P 3306 -u myuser -p SmartMedical
-    if(!mysql_real_connect(database, dbip, dbuser, dbpassword, dbname, dbport, 0, 0))
+    std::string error;
+    if(!router.open({ dbip, dbport }, parse_endpoints(std::getenv("DB_REPLICAS")),
+                    dbuser, dbpassword, dbname, db_pool_size, error))
     {
-        std::cout << "Database connection failed: " << mysql_error(database) << newl;
-        return mysql_close(database), 0;
+        std::cout << "Database connection failed: " << error << newl;
+        return 0;
     }
-    std::cout << "Database connection successful" << newl;
+    std::cout << "Database connection successful, " << router.replica_count() << " replica(s)" << newl;
+    load_search_index<s_case>(), load_search_index<s_advice>();
+    std::cout << "Search index: " << search_index.size() << " record(s)" << newl;
+    load_patient_directory();
+    load_schedule();
+    load_waitlist();
+    reminder_owner = worker == 0;
+    load_reminders();
+    std::cout << "Patient directory: " << patients.size() << " patient(s)" << newl;
+    event_bus.subscribe("chat", broadcast_chat);
+    event_bus.subscribe("search", put_search_entry);
+    event_bus.subscribe("patient", put_patient);
+    event_bus.subscribe("doctor", put_doctor_rule);
+    event_bus.subscribe("waitlist", put_waitlist);
+    event_bus.subscribe("reminder", put_reminder);
+    event_bus.subscribe("notice", sync_notices);
+    event_bus.subscribe("change", push_change);
+    event_bus.open(std::string(bus_prefix) + '.' + std::to_string(master), worker, workers);
+    std::thread([] { event_bus.run(); }).detach();
     boost::asio::io_service service;
-    tcp::acceptor acceptor(service, tcp::endpoint(tcp::v4(), port));
-    std::cout << "HospitalServer is listening on port " << port << newl;
+    tcp::acceptor acceptor(service);
+    listen_on(acceptor, port, workers > 1);
+    std::cout << "HospitalServer worker " << worker << '/' << workers
+              << " is listening on port " << port << newl;
+    std::thread([] { idle_reaper.run(); }).detach();
+    for(int i = 0; i < outbox_writers; ++i) std::thread([] { outbound.run(); }).detach();
+    std::thread([] { batcher.run(); }).detach();
+    if(reminder_owner) std::thread(run_reminders).detach();
     for(;;)
     {
         tcp::socket *socket = new tcp::socket(service);
@@ -0,0 +1,74 @@
+#pragma once
+
+// 分层时间轮: 4 级, 每级 64 格, 第 k 级一格为 64^k 个 tick; 加入任务 O(1), 推进一个 tick 时只处理当前格,
+// 高一级的格转满一圈时把其中的任务按剩余时间重新分到低级. 任务只是一个值, 不占线程,
+// 到期的任务由 advance 一次性取出, 调用方可以成批处理
+
+#include<mutex>
+#include<chrono>
+#include<vector>
+#include<utility>
+
+template<typename T, typename Clock = std::chrono::system_clock>
+class timer_wheel
+{
+public:
+    static constexpr int levels = 4, bits = 6, slots = 1 << bits;
+
+    timer_wheel(std::chrono::milliseconds tick, typename Clock::time_point start = Clock::now())
+        : tick(tick), origin(start) { }
+
+    // 已经过期的任务在下一次 advance 时取出
+    void add(typename Clock::time_point due, T value)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        long long t = (due - origin) / tick;
+        place(t < current + 1 ? current + 1 : t, std::move(value));
+        ++count;
+    }
+
+    // 推进到 now, 返回其间到期的全部任务
+    std::vector<T> advance(typename Clock::time_point now)
+    {
+        std::vector<T> ret;
+        std::lock_guard<std::mutex> lock(mu);
+        for(long long target = (now - origin) / tick; current < target;)
+        {
+            ++current;
+            for(int k = 1; k < levels && !(current & ((1LL << bits * k) - 1)); ++k)
+            {
+                auto moved = std::move(wheel[k][current >> bits * k & (slots - 1)]);
+                wheel[k][current >> bits * k & (slots - 1)].clear();
+                for(auto &e : moved) place(e.first, std::move(e.second));
+            }
+            auto &slot = wheel[0][current & (slots - 1)];
+            for(auto &e : slot) ret.push_back(std::move(e.second));
+            count -= slot.size(), slot.clear();
+        }
+        return ret;
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        return count;
+    }
+
+private:
+    // 放到能容纳剩余时间的最低一级; 超出最高一级范围的先挂在最高一级最远的格上, 转到时再重新分
+    void place(long long t, T value)
+    {
+        long long delta = t - current;
+        int k = 0;
+        while(k < levels - 1 && delta >= 1LL << bits * (k + 1)) ++k;
+        long long at = delta >= 1LL << bits * levels ? current + ((1LL << bits * levels) - (1LL << bits * (levels - 1))) : t;
+        wheel[k][at >> bits * k & (slots - 1)].push_back({ t, std::move(value) });
+    }
+
+    std::chrono::milliseconds tick;
+    typename Clock::time_point origin;
+    std::mutex mu;
+    long long current = 0;
+    size_t count = 0;
+    std::vector<std::pair<long long, T>> wheel[levels][slots];
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+// 候补队列: 每个 (医生, 日期) 一个先来先到的队列, 持久化在 waitlist 表里, 内存中的副本经总线在各 worker 间同步;
+// 有人取消或医生放出新号时按队列顺序递补, 患者不必反复重试预约
+
+#include<map>
+#include<mutex>
+#include<deque>
+#include<string>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<string_view>
+
+class waitlist
+{
+public:
+    // 已在队列中时不重复加入, 返回排在第几位(从 1 开始)
+    int join(std::string_view doctor, int date, std::string_view patient)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto &q = queues[{ std::string(doctor), date }];
+        auto it = std::find(q.begin(), q.end(), patient);
+        if(it == q.end()) it = q.insert(q.end(), std::string(patient));
+        return it - q.begin() + 1;
+    }
+    bool leave(std::string_view doctor, int date, std::string_view patient)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto k = queues.find({ std::string(doctor), date });
+        if(k == queues.end()) return false;
+        auto it = std::find(k->second.begin(), k->second.end(), patient);
+        if(it == k->second.end()) return false;
+        k->second.erase(it);
+        if(k->second.empty()) queues.erase(k);
+        return true;
+    }
+    // 队列当前内容的拷贝, 递补时按顺序尝试
+    std::vector<std::string> snapshot(std::string_view doctor, int date) const
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto k = queues.find({ std::string(doctor), date });
+        if(k == queues.end()) return { };
+        return { k->second.begin(), k->second.end() };
+    }
+    // 该医生有人候补的日期
+    std::vector<int> dates(std::string_view doctor) const
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        std::vector<int> ret;
+        for(auto it = queues.lower_bound({ std::string(doctor), 0 }); it != queues.end() && it->first.first == doctor; ++it)
+            ret.push_back(it->first.second);
+        return ret;
+    }
+
+private:
+    mutable std::mutex mu;
+    std::map<std::pair<std::string, int>, std::deque<std::string>> queues;
+};
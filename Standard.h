@@ -17,6 +17,7 @@
 #include"Instance/StateManager.h"
 #include"Fun./JsonMessageBuilder.h"
 #include"Fun./DataManager.h"
+#include"Fun./RecordModel.h"
 
 
 #endif // STANDARD_H
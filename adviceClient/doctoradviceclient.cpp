@@ -7,9 +7,9 @@ doctorAdviceClient::doctorAdviceClient(QWidget *parent)
 {
     ui->setupUi(this);
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorAdviceClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorAdvice, this, &doctorAdviceClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &doctorAdviceClient::onErrorOccurred);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorAdviceClient::onDataReceivedJudge);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorAdviceJudge, this, &doctorAdviceClient::onDataReceivedJudge);
 
     ui->medicineLineEdit->setReadOnly(true);
     ui->checkLineEdit->setReadOnly(true);
@@ -26,13 +26,6 @@ void doctorAdviceClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorAdvice) {
-        qDebug() << "doctorAdviceClient::onDataReceived:当前不是患者医嘱列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"doctorAdviceClient::onDataReceived:状态设置为Idle";
@@ -91,13 +84,6 @@ void doctorAdviceClient::onDataReceivedJudge(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorAdviceJudge) {
-        qDebug() << "doctorAdviceClient::onDataReceived:当前不是患者病例列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"doctorAdviceClient::onDataReceived:状态设置为Idle";
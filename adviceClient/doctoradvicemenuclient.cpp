@@ -8,7 +8,7 @@ doctorAdviceMenuClient::doctorAdviceMenuClient(QWidget *parent)
     ui->setupUi(this);
 
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorAdviceMenuClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorAdviceList, this, &doctorAdviceMenuClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &doctorAdviceMenuClient::onErrorOccurred);
 
 }
@@ -22,13 +22,6 @@ void doctorAdviceMenuClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorAdviceList) {
-        qDebug() << "doctorAdviceMenuClient::onDataReceived:当前不是患者医嘱列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"doctorAdviceMenuClient::onDataReceived:状态设置为Idle";
@@ -8,7 +8,7 @@ patientAdviceClient::patientAdviceClient(QWidget *parent)
 {
     ui->setupUi(this);
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &patientAdviceClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientAdviceList, this, &patientAdviceClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &patientAdviceClient::onErrorOccurred);
 
 }
@@ -19,16 +19,6 @@ patientAdviceClient::~patientAdviceClient()
 }
 
 void patientAdviceClient::onDataReceived(const QJsonObject &data){
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitRecivePatientAdviceList) {
-        qDebug() << "patientCaseMenuClient::onDataReceived:当前不是患者病例列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"patientAdviceClient::onDataReceived:状态设置为:Idle";
 
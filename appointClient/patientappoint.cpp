@@ -9,9 +9,9 @@ patientAppoint::patientAppoint(QWidget *parent)
 
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &patientAppoint::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveAvailableDoctortList, this, &patientAppoint::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &patientAppoint::onErrorOccurred);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &patientAppoint::onJudgeReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientAppointmentJudge, this, &patientAppoint::onJudgeReceived);
     ui->comboBox->addItem("呼吸内科");
     ui->comboBox->addItem("消化内科");
     ui->comboBox->addItem("心内科");
@@ -24,6 +24,20 @@ patientAppoint::patientAppoint(QWidget *parent)
     ui->comboBox->addItem("泌尿外科");
     ui->comboBox->addItem("妇产科");
     ui->comboBox->addItem("儿科");
+
+    // 表格和医生下拉框共用一个模型
+    doctorModel = new RecordModel({
+        { "医生", "name", nullptr },
+        { "医生用户名", "username", nullptr },
+        { "出诊时间", QString(), [](const QJsonObject &d) { return d["begin"].toString() + "-" + d["end"].toString(); } },
+        { "费用", "cost", nullptr },
+        { "科室", "department", nullptr },
+        { "最大挂号上限", "limit", nullptr },
+    }, [](const QJsonObject &d) { return d["username"].toString(); }, this);
+    ui->availableDoctorTableView->setModel(doctorModel);
+    RecordModel::setupView(ui->availableDoctorTableView);
+    ui->comboBox_2->setModel(doctorModel);
+    ui->comboBox_2->setModelColumn(1);
 }
 
 patientAppoint::~patientAppoint()
@@ -32,35 +46,14 @@ patientAppoint::~patientAppoint()
 }
 
 void patientAppoint::onDataReceived(const QJsonObject &data){
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveAvailableDoctortList) {
-        qDebug() << "patientAppoint::onDataReceived:当前不是医生列表接收状态，忽略接收到的数据";
-        return;
-    }
-
      // 完成后恢复为 Idle 状态
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"patientAppoint::onDataReceived:状态设置为:Idle";
 
     qDebug()<<"patientAppoint::onDataReceived:正在接收医生列表列表";
 
-
-
-    QList<DataManager::DoctorInfo> doctors=DataManager::instance().extractDoctors(data);
-
-    for (const DataManager::DoctorInfo &doctor : doctors) {
-        const QString each_instance=QString("医生：")+QString(doctor.name)
-                                      +QString("    医生用户名：")+QString(doctor.username)+QString("    出诊时间：")
-                                      +QString(doctor.begin)+QString("-")+QString(doctor.end)
-                                      +QString("  费用：")+QString(doctor.cost)
-                                      +QString("    科室：")+QString(doctor.department)
-                                      +QString("    最大挂号上限")+QString(doctor.limit);
-        ui->availableDoctorListWidget->addItem(each_instance);
-        ui->comboBox_2->addItem(QString(doctor.username));
-    }
+    // 先显示缓存、再收到更新后的列表时按医生合并，只重绘有变化的行
+    doctorModel->sync(RecordModel::recordsIn(data, "doctor_"));
 
 
 };  // 添加数据接收槽
@@ -73,15 +66,6 @@ void patientAppoint::onErrorOccurred(const QString &error){
 
 void patientAppoint::onJudgeReceived(const QJsonObject &data){
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitRecivePatientAppointmentJudge) {
-        qDebug() << "patientAppoint::onDataReceived:当前不是患者预约判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"patientAppoint::onDataReceived:状态设置为:Idle";
 
@@ -97,18 +81,18 @@ void patientAppoint::onJudgeReceived(const QJsonObject &data){
 
     if(replyStatus=="successful"){
         QMessageBox::information(this,"提示","您的预约已成功提交");
+    }else if(replyStatus=="full"){
+        // 当天已约满：询问是否排队候补，有号空出时自动递补
+        if(QMessageBox::question(this, "预约已满", "该医生当天的号已约满，是否加入候补队列？") == QMessageBox::Yes){
+            joinWaitlist();
+        }
+    }else if(replyStatus=="occupied"){
+        QMessageBox::warning(this, "预约提交失败", "该时段已被预约，请选择其他时段");
     }else{
-        QMessageBox::warning(this, "预约提交失败", "服务器返回数据格式错误");
+        QMessageBox::warning(this, "预约提交失败", "预约失败：" + replyStatus);
     }
 
-    //更新patient_client的预约列表显示
-    StateManager::instance().setState(WidgetState::waitRecivePatientAppointmentList);
-    qDebug()<<"patientAppoint::onDataReceived:状态设置为:waitRecivePatientAppointmentList";
-
-    JsonMessageBuilder *builder=new JsonMessageBuilder("queryAppointmentList");
-    tcpClient->sendData(builder->build());
-    delete builder; // 记得释放内存
-
+    // patient_client 的预约列表由变更推送更新，这里不再重新查询
 }
 
 void patientAppoint::on_pushButton_clicked()
@@ -116,10 +100,6 @@ void patientAppoint::on_pushButton_clicked()
     StateManager::instance().setState(WidgetState::waitReciveAvailableDoctortList);
     qDebug()<<"patientAppoint::on_pushButton_clicked:状态设置为:waitReciveAvailableDoctortList";
 
-    //这里一定要清空，不然多次查询会导致累计
-    ui->availableDoctorListWidget->clear();
-    ui->comboBox_2->clear();
-
     JsonMessageBuilder *builder = new JsonMessageBuilder("queryDoctorList");
     builder->addAdditionalData("time",ui->spinBox->text());
     tcpClient->sendData(builder->build());
@@ -139,10 +119,33 @@ void patientAppoint::on_commitDoctorPushButton_clicked()
                       .arg(ui->yearSpinBox->value(), 4, 10, QChar('0'))
                       .arg(ui->monthSpinBox->value(), 2, 10, QChar('0'))
                       .arg(ui->daySpinBox->value(), 2, 10, QChar('0'));
+    // 约满时加入候补要用同一医生和日期
+    m_doctor = ui->comboBox_2->currentText();
+    m_date = date;
     builder->addAppointment(UserSession::instance().getValue("username"),
-                            ui->comboBox_2->currentText(),date,
+                            m_doctor,date,
                             ui->spinBox->text(),"0",QString("waiting"));
     tcpClient->sendData(builder->build());
     delete builder;
 }
 
+void patientAppoint::joinWaitlist()
+{
+    QJsonObject data;
+    data["patientUsername"] = UserSession::instance().getValue("username");
+    data["doctorUsername"] = m_doctor;
+    data["date"] = m_date;
+    tcpClient->request("joinWaitlist", data, [this](const QJsonObject &reply) {
+        if (reply["reply"].toString() != "successful") {
+            QMessageBox::warning(this, "候补失败", "加入候补队列失败：" + reply["reply"].toString());
+            return;
+        }
+        const int position = reply["position"].toInt();
+        if (position == 0) {
+            QMessageBox::information(this, "提示", "已有号空出，您的预约已自动递补成功");
+        } else {
+            QMessageBox::information(this, "提示", QString("已加入候补队列，当前排在第 %1 位，递补成功后会收到通知").arg(position));
+        }
+    }, this);
+}
+
@@ -26,6 +26,11 @@ private slots:
 private:
     Ui::patientAppoint *ui;
     TcpClient *tcpClient = TcpClient::instance();
+    RecordModel *doctorModel;  // 可预约的医生，按用户名区分
+    QString m_doctor;  // 最近一次提交预约的医生和日期（yyyyMMdd）
+    QString m_date;
+
+    void joinWaitlist();  // 约满后排队候补，显示排队位置
 };
 
 #endif // PATIENTAPPOINT_H
@@ -8,7 +8,7 @@ doctorCaseClient::doctorCaseClient(QWidget *parent)
 {
     ui->setupUi(this);
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorCaseClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorCaseList, this, &doctorCaseClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &doctorCaseClient::onErrorOccurred);
 
 
@@ -24,13 +24,6 @@ void doctorCaseClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorCaseList) {
-        qDebug() << "patientCaseMenuClient::onDataReceived:当前不是患者病例列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"patientCaseMenuClient::onDataReceived:状态设置为Idle";
@@ -8,9 +8,9 @@ doctorCaseEditClient::doctorCaseEditClient(QWidget *parent)
 {
     ui->setupUi(this);
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorCaseEditClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorCase, this, &doctorCaseEditClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &doctorCaseEditClient::onErrorOccurred);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorCaseEditClient::onDataReceivedJudge);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorCaseJudge, this, &doctorCaseEditClient::onDataReceivedJudge);
 
     ui->mainLineEdit->setReadOnly(true);
     ui->checkLineEdit->setReadOnly(true);
@@ -38,13 +38,6 @@ void doctorCaseEditClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorCase) {
-        qDebug() << "doctorCaseEditClient::onDataReceived:当前不是患者病例列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"doctorCaseEditClient::onDataReceived:状态设置为Idle";
@@ -141,13 +134,6 @@ void doctorCaseEditClient::onDataReceivedJudge(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorCaseJudge) {
-        qDebug() << "doctorCaseEditClient::onDataReceived:当前不是患者病例列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"doctorCaseEditClient::onDataReceived:状态设置为Idle";
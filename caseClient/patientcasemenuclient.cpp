@@ -8,7 +8,7 @@ patientCaseMenuClient::patientCaseMenuClient(QWidget *parent)
     ui->setupUi(this);
 
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &patientCaseMenuClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientCaseList, this, &patientCaseMenuClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &patientCaseMenuClient::onErrorOccurred);
 
 
@@ -27,13 +27,6 @@ void patientCaseMenuClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitRecivePatientCaseList) {
-        qDebug() << "patientCaseMenuClient::onDataReceived:当前不是患者病例列表接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"patientCaseMenuClient::onDataReceived:状态设置为Idle";
@@ -8,7 +8,7 @@ adminCheckInClient::adminCheckInClient(QWidget *parent)
     ui->setupUi(this);
 
  tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &adminCheckInClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitAdminReciveDoctorList, this, &adminCheckInClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &adminCheckInClient::onErrorOccurred);
 }
 
@@ -21,13 +21,6 @@ void adminCheckInClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitAdminReciveDoctorList) {
-        qDebug() << "adminCheckInClient::onDataReceived:当前不是医生接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"adminCheckInClient::onDataReceived:状态设置为Idle";
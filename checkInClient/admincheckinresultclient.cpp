@@ -8,7 +8,7 @@ adminCheckInResultClient::adminCheckInResultClient(QWidget *parent)
     ui->setupUi(this);
 
      tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &adminCheckInResultClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitAdminReciveCheckin, this, &adminCheckInResultClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &adminCheckInResultClient::onErrorOccurred);
 }
 
@@ -21,13 +21,6 @@ void adminCheckInResultClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitAdminReciveCheckin) {
-        qDebug() << "adminCheckInResultClient::onDataReceived:当前不是医生考勤接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"adminCheckInResultClient::onDataReceived:状态设置为Idle";
@@ -9,10 +9,10 @@ doctorCheckInClient::doctorCheckInClient(QWidget *parent)
     ui->setupUi(this);
 
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorCheckInClient::onJudgeReceivedAttendence);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorCheckInClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorAttendance, this, &doctorCheckInClient::onJudgeReceivedAttendence);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorCheckin, this, &doctorCheckInClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &doctorCheckInClient::onErrorOccurred);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorCheckInClient::onJudgeReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorAbcenceJudge, this, &doctorCheckInClient::onJudgeReceived);
 
 
 
@@ -73,13 +73,6 @@ void doctorCheckInClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorCheckin) {
-        qDebug() << "doctorCheckInClient::onDataReceived:当前不是医生考勤接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"doctorCheckInClient::onDataReceived:状态设置为Idle";
@@ -124,15 +117,6 @@ void doctorCheckInClient::onErrorOccurred(const QString &error){
 
 void doctorCheckInClient::onJudgeReceived(const QJsonObject &data){
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorAbcenceJudge) {
-        qDebug() << "doctorCheckInClient::onJudgeReceived当前不是医生请假判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"doctorCheckInClient::onJudgeReceived状态设置为:Idle";
 
@@ -168,15 +152,6 @@ void doctorCheckInClient::onJudgeReceived(const QJsonObject &data){
 void doctorCheckInClient::onJudgeReceivedAttendence(const QJsonObject &data){
 
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorAttendance) {
-        qDebug() << "doctorCheckInClient::onJudgeReceived当前不是医生考勤判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"doctorCheckInClient::onJudgeReceived状态设置为:Idle";
 
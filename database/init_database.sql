@@ -44,9 +44,23 @@ CREATE TABLE IF NOT EXISTS `appointment` (
   `date` DATE NOT NULL,
   `time` TIME NOT NULL,
   `cost` DECIMAL(10,2) NOT NULL,
-  `status` ENUM('pending', 'confirmed', 'cancelled', 'completed') DEFAULT 'pending',
+  `status` ENUM('pending', 'waiting', 'accept', 'confirmed', 'cancelled', 'completed') DEFAULT 'pending',
+  `reminded` BOOLEAN DEFAULT FALSE COMMENT '是否已发就诊提醒',
   FOREIGN KEY (`patientUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE,
-  FOREIGN KEY (`doctorUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE
+  FOREIGN KEY (`doctorUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE,
+  UNIQUE KEY unique_appointment (`patientUsername`, `doctorUsername`, `date`, `time`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+-- 候补表: 医生某天约满时排队, 有号空出时按 id 顺序递补
+CREATE TABLE IF NOT EXISTS `waitlist` (
+  `id` INT AUTO_INCREMENT PRIMARY KEY,
+  `patientUsername` VARCHAR(50) NOT NULL,
+  `doctorUsername` VARCHAR(50) NOT NULL,
+  `date` DATE NOT NULL,
+  `createTime` DATETIME DEFAULT CURRENT_TIMESTAMP,
+  FOREIGN KEY (`patientUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE,
+  FOREIGN KEY (`doctorUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE,
+  UNIQUE KEY unique_waitlist (`patientUsername`, `doctorUsername`, `date`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
 -- 病历表
@@ -61,6 +75,7 @@ CREATE TABLE IF NOT EXISTS `case` (
   `past` TEXT COMMENT '既往史',
   `check` TEXT COMMENT '检查结果',
   `diagnose` TEXT COMMENT '诊断',
+  `updated` TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3) COMMENT '最后修改时间, 客户端按它增量同步',
   FOREIGN KEY (`patientUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE,
   FOREIGN KEY (`doctorUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
@@ -76,6 +91,7 @@ CREATE TABLE IF NOT EXISTS `advice` (
   `check` TEXT COMMENT '检查建议',
   `therapy` TEXT COMMENT '治疗建议',
   `care` TEXT COMMENT '护理建议',
+  `updated` TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3) COMMENT '最后修改时间, 客户端按它增量同步',
   FOREIGN KEY (`patientUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE,
   FOREIGN KEY (`doctorUsername`) REFERENCES `account`(`username`) ON DELETE CASCADE
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
@@ -84,18 +100,35 @@ CREATE TABLE IF NOT EXISTS `advice` (
 CREATE TABLE IF NOT EXISTS `notice` (
   `id` INT AUTO_INCREMENT PRIMARY KEY,
   `username` VARCHAR(50) NOT NULL,
-  `type` ENUM('appointment', 'case', 'system', 'reminder') NOT NULL,
+  `type` ENUM('appointment', 'case', 'system', 'reminder', 'admin', 'patient', 'doctor') NOT NULL,
   `message` TEXT NOT NULL,
   `time` DATETIME DEFAULT CURRENT_TIMESTAMP,
   FOREIGN KEY (`username`) REFERENCES `account`(`username`) ON DELETE CASCADE
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
+-- 通知已读游标表: 每个用户已确认收到的最大通知 id, 重新连接时只推送之后的通知
+CREATE TABLE IF NOT EXISTS `noticeCursor` (
+  `username` VARCHAR(50) PRIMARY KEY,
+  `lastId` INT NOT NULL DEFAULT 0,
+  FOREIGN KEY (`username`) REFERENCES `account`(`username`) ON DELETE CASCADE
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+-- 会话令牌表: 登录时签发, 断线重连后凭令牌恢复会话, 不必重新登录
+CREATE TABLE IF NOT EXISTS `session` (
+  `token` CHAR(32) PRIMARY KEY,
+  `username` VARCHAR(50) NOT NULL,
+  `type` ENUM('patient', 'doctor', 'admin') NOT NULL,
+  `expires` DATETIME NOT NULL,
+  INDEX `idx_session_username` (`username`),
+  FOREIGN KEY (`username`) REFERENCES `account`(`username`) ON DELETE CASCADE
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
 -- 医生工作安排表
 CREATE TABLE IF NOT EXISTS `work` (
   `id` INT AUTO_INCREMENT PRIMARY KEY,
   `username` VARCHAR(50) NOT NULL,
   `date` DATE NOT NULL,
-  `status` ENUM('available', 'busy', 'off') DEFAULT 'available',
+  `status` ENUM('available', 'busy', 'off', 'clock', 'leave') DEFAULT 'available' COMMENT '打卡记为 clock, 请假记为 leave',
   FOREIGN KEY (`username`) REFERENCES `account`(`username`) ON DELETE CASCADE,
   UNIQUE KEY unique_work (`username`, `date`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
@@ -114,6 +147,45 @@ CREATE TABLE IF NOT EXISTS `question` (
   `createTime` DATETIME DEFAULT CURRENT_TIMESTAMP
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
+-- 升级已有数据库: 上面的 CREATE TABLE IF NOT EXISTS 对已存在的表不起作用(新表照常创建),
+-- 已有表新增的列、索引和枚举取值在这里补上. 每条都先查 information_schema, 重复执行不会出错
+DROP PROCEDURE IF EXISTS add_column_if_missing;
+DROP PROCEDURE IF EXISTS add_index_if_missing;
+DELIMITER //
+CREATE PROCEDURE add_column_if_missing(IN t VARCHAR(64), IN c VARCHAR(64), IN definition TEXT)
+BEGIN
+  IF NOT EXISTS (SELECT 1 FROM information_schema.COLUMNS
+                 WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = t AND COLUMN_NAME = c) THEN
+    SET @ddl = CONCAT('ALTER TABLE `', t, '` ADD COLUMN `', c, '` ', definition);
+    PREPARE stmt FROM @ddl;
+    EXECUTE stmt;
+    DEALLOCATE PREPARE stmt;
+  END IF;
+END //
+CREATE PROCEDURE add_index_if_missing(IN t VARCHAR(64), IN i VARCHAR(64), IN definition TEXT)
+BEGIN
+  IF NOT EXISTS (SELECT 1 FROM information_schema.STATISTICS
+                 WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = t AND INDEX_NAME = i) THEN
+    SET @ddl = CONCAT('ALTER TABLE `', t, '` ADD ', definition);
+    PREPARE stmt FROM @ddl;
+    EXECUTE stmt;
+    DEALLOCATE PREPARE stmt;
+  END IF;
+END //
+DELIMITER ;
+
+ALTER TABLE `appointment` MODIFY `status` ENUM('pending', 'waiting', 'accept', 'confirmed', 'cancelled', 'completed') DEFAULT 'pending';
+CALL add_column_if_missing('appointment', 'reminded', 'BOOLEAN DEFAULT FALSE COMMENT ''是否已发就诊提醒''');
+-- 已有重复预约(同一患者、医生、日期、时间)时这一步会失败, 需要先手工合并
+CALL add_index_if_missing('appointment', 'unique_appointment',
+  'UNIQUE KEY `unique_appointment` (`patientUsername`, `doctorUsername`, `date`, `time`)');
+CALL add_column_if_missing('case', 'updated',
+  'TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3) COMMENT ''最后修改时间, 客户端按它增量同步''');
+CALL add_column_if_missing('advice', 'updated',
+  'TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3) COMMENT ''最后修改时间, 客户端按它增量同步''');
+ALTER TABLE `notice` MODIFY `type` ENUM('appointment', 'case', 'system', 'reminder', 'admin', 'patient', 'doctor') NOT NULL;
+ALTER TABLE `work` MODIFY `status` ENUM('available', 'busy', 'off', 'clock', 'leave') DEFAULT 'available' COMMENT '打卡记为 clock, 请假记为 leave';
+
 -- 插入测试数据
 -- 管理员账户
 INSERT IGNORE INTO `account` (`username`, `type`, `reverse`) VALUES ('admin', 'admin', 'admin123');
@@ -141,10 +213,18 @@ INSERT IGNORE INTO `appointment` (`patientUsername`, `doctorUsername`, `date`, `
 ('patient1', 'doctor1', CURDATE(), '09:00:00', 50.00, 'confirmed'),
 ('patient2', 'doctor2', CURDATE() + INTERVAL 1 DAY, '10:00:00', 80.00, 'pending');
 
--- 创建索引提高查询性能
-CREATE INDEX idx_appointment_doctor_date ON `appointment`(`doctorUsername`, `date`);
-CREATE INDEX idx_appointment_patient_date ON `appointment`(`patientUsername`, `date`);
-CREATE INDEX idx_case_patient_doctor ON `case`(`patientUsername`, `doctorUsername`);
-CREATE INDEX idx_advice_patient_doctor ON `advice`(`patientUsername`, `doctorUsername`);
-CREATE INDEX idx_notice_username_time ON `notice`(`username`, `time`);
-CREATE INDEX idx_work_username_date ON `work`(`username`, `date`);
\ No newline at end of file
+-- 创建索引提高查询性能(已存在的跳过, 脚本可以重复执行)
+CALL add_index_if_missing('appointment', 'idx_appointment_doctor_date', 'INDEX `idx_appointment_doctor_date` (`doctorUsername`, `date`)');
+CALL add_index_if_missing('appointment', 'idx_appointment_patient_date', 'INDEX `idx_appointment_patient_date` (`patientUsername`, `date`)');
+CALL add_index_if_missing('waitlist', 'idx_waitlist_doctor_date', 'INDEX `idx_waitlist_doctor_date` (`doctorUsername`, `date`)');
+CALL add_index_if_missing('case', 'idx_case_patient_doctor', 'INDEX `idx_case_patient_doctor` (`patientUsername`, `doctorUsername`)');
+CALL add_index_if_missing('advice', 'idx_advice_patient_doctor', 'INDEX `idx_advice_patient_doctor` (`patientUsername`, `doctorUsername`)');
+CALL add_index_if_missing('case', 'idx_case_patient_updated', 'INDEX `idx_case_patient_updated` (`patientUsername`, `updated`)');
+CALL add_index_if_missing('case', 'idx_case_doctor_updated', 'INDEX `idx_case_doctor_updated` (`doctorUsername`, `updated`)');
+CALL add_index_if_missing('advice', 'idx_advice_patient_updated', 'INDEX `idx_advice_patient_updated` (`patientUsername`, `updated`)');
+CALL add_index_if_missing('advice', 'idx_advice_doctor_updated', 'INDEX `idx_advice_doctor_updated` (`doctorUsername`, `updated`)');
+CALL add_index_if_missing('notice', 'idx_notice_username_time', 'INDEX `idx_notice_username_time` (`username`, `time`)');
+CALL add_index_if_missing('work', 'idx_work_username_date', 'INDEX `idx_work_username_date` (`username`, `date`)');
+
+DROP PROCEDURE IF EXISTS add_column_if_missing;
+DROP PROCEDURE IF EXISTS add_index_if_missing;
\ No newline at end of file
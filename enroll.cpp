@@ -13,7 +13,7 @@ Enroll::Enroll(QWidget *parent)
     // 初始化 TCP 客户端
 
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &Enroll::onRegisterFinished);
+    ReplyDispatcher::instance().route(WidgetState::Registing, this, &Enroll::onRegisterFinished);
     connect(tcpClient, &TcpClient::errorOccurred, this, &Enroll::onErrorOccurred);
 
 }
@@ -65,12 +65,6 @@ void Enroll::onRegisterFinished(const QJsonObject &data)
     // 获取 StateManager 单例
         StateManager& stateManager = StateManager::instance();
 
-    // 如果当前不是注册状态，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::Registing) {
-        qDebug() << "当前不是注册状态，忽略接收到的数据";
-        return;
-    }
-
     // 注册完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"Enroll::on_EnrollWindow_enroll_pushButton_clicked:状态设置为Idle";
@@ -8,7 +8,7 @@ adminInfoClient::adminInfoClient(QWidget *parent)
     ui->setupUi(this);
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &adminInfoClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitdie_3, this, &adminInfoClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &adminInfoClient::onErrorOccurred);
 
     //开启只读
@@ -30,12 +30,6 @@ void adminInfoClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitdie_3) {
-        qDebug() << "adminInfoClient::onDataReceived:当前不是患者信息接收状态，忽略接收到的数据";
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
 
@@ -106,15 +100,6 @@ void adminInfoClient::on_savePushButton_clicked()
 
 void adminInfoClient::onJudgeReceived(const QJsonObject &data){
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitdie_4) {
-        qDebug() << "adminInfoClient::onJudgeReceived:当前不是患者信息编辑判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"adminInfoClient::onJudgeReceived:状态设置为:Idle";
 
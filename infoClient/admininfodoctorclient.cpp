@@ -9,10 +9,10 @@ adminInfoDoctorClient::adminInfoDoctorClient(QWidget *parent)
     ui->setupUi(this);
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &adminInfoDoctorClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitdie_2, this, &adminInfoDoctorClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &adminInfoDoctorClient::onErrorOccurred);
 
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &adminInfoDoctorClient::onJudgeReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitdie_5, this, &adminInfoDoctorClient::onJudgeReceived);
 }
 
 adminInfoDoctorClient::~adminInfoDoctorClient()
@@ -24,12 +24,6 @@ void adminInfoDoctorClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitdie_2) {
-        qDebug() << "adminInfoDoctorClient::onDataReceived:当前不是医生信息接收状态，忽略接收到的数据";
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
 
@@ -127,15 +121,6 @@ void adminInfoDoctorClient::on_savePushButton_2_clicked()
 
 void adminInfoDoctorClient::onJudgeReceived(const QJsonObject &data){
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitdie_5) {
-        qDebug() << "adminInfoDoctorClient::onJudgeReceived:当前不是患者信息编辑判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"adminInfoDoctorClient::onJudgeReceived:状态设置为:Idle";
 
@@ -7,10 +7,17 @@ adminInfoMenuClient::adminInfoMenuClient(QWidget *parent)
 {
     ui->setupUi(this);
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &adminInfoMenuClient::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitdie, this, &adminInfoMenuClient::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &adminInfoMenuClient::onErrorOccurred);
     ui->typeComboBox->addItem("Patient");
     ui->typeComboBox->addItem("Doctor");
+
+    auto username = [](const QJsonObject &record) { return record["username"].toString(); };
+    doctorModel = new RecordModel({ { "医生用户名", "username", nullptr }, { "医生名", "name", nullptr } }, username, this);
+    patientModel = new RecordModel({ { "患者用户名", "username", nullptr }, { "患者名", "name", nullptr } }, username, this);
+    RecordModel::setupView(ui->tableView);
+    ui->tableView->setModel(currentModel());
+    ui->comboBox_2->setModel(currentModel());
 }
 
 adminInfoMenuClient::~adminInfoMenuClient()
@@ -23,13 +30,6 @@ void adminInfoMenuClient::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitdie) {
-        qDebug() << "adminInfoMenuClient::onDataReceived:当前不是个人信息接收状态，忽略接收到的数据";
-
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
     qDebug()<<"adminInfoMenuClient::onDataReceived:状态设置为Idle";
@@ -49,28 +49,15 @@ void adminInfoMenuClient::onDataReceived(const QJsonObject &data){
     }else{
         QMessageBox::warning(this, "失败", "服务器返回数据格式错误");
     }
-    if(ui->typeComboBox->currentText()=="Doctor"){
-    QList<DataManager::DoctorInfo> doctors=DataManager::instance().extractDoctors(data);
-
-    for (const DataManager::DoctorInfo &doctor : doctors) {
-        const QString each_instance=QString("医生用户名：")+QString(doctor.username)
-                                      +QString("    医生名：")+QString(doctor.name);
-        ui->listWidget->addItem(each_instance);
-        ui->comboBox_2->addItem(QString(doctor.username));
-    }
-    }else{
-
-        QList<DataManager::PatientInfo> patients=DataManager::instance().extractPatients(data);
-
-        for (const DataManager::PatientInfo &patient : patients) {
-            const QString each_instance=QString("患者用户名：")+QString(patient.username)
-                                          +QString("    患者名：")+QString(patient.name);
-            ui->listWidget->addItem(each_instance);
-            ui->comboBox_2->addItem(QString(patient.username));
-        }
-    }
+    // 表格和用户名下拉框共用一个模型，只更新有变化的行
+    currentModel()->sync(RecordModel::recordsIn(data, ui->typeComboBox->currentText()=="Doctor" ? "doctor_" : "patient_"));
 
 }  // 添加数据接收槽
+
+RecordModel *adminInfoMenuClient::currentModel()
+{
+    return ui->typeComboBox->currentText()=="Doctor" ? doctorModel : patientModel;
+}
 void adminInfoMenuClient::onErrorOccurred(const QString &error){
 
     QMessageBox::warning(this, "网络错误", error);
@@ -81,8 +68,13 @@ void adminInfoMenuClient::onErrorOccurred(const QString &error){
 
 void adminInfoMenuClient::on_pushButton_clicked()
 {
-    ui->listWidget->clear();
-    ui->comboBox_2->clear();
+    // 切换到所查类型的列表，旧内容留到新列表到达时再按行更新
+    if (ui->tableView->model() != currentModel()) {
+        QItemSelectionModel *selection = ui->tableView->selectionModel();
+        ui->tableView->setModel(currentModel());
+        delete selection;  // setModel 不会释放旧的选择模型
+        ui->comboBox_2->setModel(currentModel());
+    }
 
     JsonMessageBuilder *builder =new JsonMessageBuilder("query"+ui->typeComboBox->currentText()+"List");
 
@@ -26,10 +26,14 @@ private slots:
     void on_pushButton_2_clicked();
 
 private:
+    RecordModel *currentModel();  // 按类型下拉框选择医生或患者列表
+
     Ui::adminInfoMenuClient *ui;
     TcpClient *tcpClient = TcpClient::instance();
     adminInfoClient *admininfoclient=nullptr;
     adminInfoDoctorClient *admininfodoctorclient=nullptr;
+    RecordModel *doctorModel;   // 按用户名区分
+    RecordModel *patientModel;
 };
 
 #endif // ADMININFOMENUCLIENT_H
@@ -12,9 +12,9 @@ doctorInfo::doctorInfo(QWidget *parent)
 
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorInfo::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorInfo, this, &doctorInfo::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &doctorInfo::onErrorOccurred);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &doctorInfo::onJudgeReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorInfoEdit, this, &doctorInfo::onJudgeReceived);
 
 }
 
@@ -27,12 +27,6 @@ void doctorInfo::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorInfo) {
-        qDebug() << "doctorinfo::onDataReceived:当前不是医生信息接收状态，忽略接收到的数据";
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
 
@@ -129,15 +123,6 @@ void doctorInfo::on_savePushButton_2_clicked()
 
 void doctorInfo::onJudgeReceived(const QJsonObject &data){
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitReciveDoctorInfoEdit) {
-        qDebug() << "doctorInfo::onJudgeReceived:当前不是患者信息编辑判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"doctorInfo::onJudgeReceived:状态设置为:Idle";
 
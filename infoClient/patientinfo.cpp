@@ -10,9 +10,9 @@ patientInfo::patientInfo(QWidget *parent)
 
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &patientInfo::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientInfo, this, &patientInfo::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &patientInfo::onErrorOccurred);
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &patientInfo::onJudgeReceived);
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientInfoEdit, this, &patientInfo::onJudgeReceived);
 
 
 
@@ -29,12 +29,6 @@ void patientInfo::onDataReceived(const QJsonObject &data){
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitRecivePatientInfo) {
-        qDebug() << "patientinfo::onDataReceived:当前不是患者信息接收状态，忽略接收到的数据";
-        return;
-    }
-
     // 完成后恢复为 Idle 状态
     stateManager.setState(WidgetState::Idle);
 
@@ -78,15 +72,6 @@ void patientInfo::onDataReceived(const QJsonObject &data){
 
 void patientInfo::onJudgeReceived(const QJsonObject &data){
 
-    // 获取 StateManager 单例
-    StateManager& stateManager = StateManager::instance();
-
-    // 如果状态不合，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::waitRecivePatientInfoEdit) {
-        qDebug() << "patientinfo::onJudgeReceived:当前不是患者信息编辑判断接收状态，忽略接收到的数据";
-        return;
-    }
-
     StateManager::instance().setState(WidgetState::Idle);
     qDebug()<<"patientinfo::onJudgeReceived:状态设置为:Idle";
 
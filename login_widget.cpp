@@ -59,7 +59,7 @@ Login_Widget::Login_Widget(QWidget *parent)
 
     // 初始化 TCP 客户端
     tcpClient = TcpClient::instance();
-    connect(tcpClient, &TcpClient::dataReceivedJson, this, &Login_Widget::onDataReceived);
+    ReplyDispatcher::instance().route(WidgetState::LoggingIn, this, &Login_Widget::onDataReceived);
     connect(tcpClient, &TcpClient::errorOccurred, this, &Login_Widget::onErrorOccurred);
 
 
@@ -161,11 +161,6 @@ void Login_Widget::onDataReceived(const QJsonObject &data)
     // 获取 StateManager 单例
     StateManager& stateManager = StateManager::instance();
 
-    // 如果当前不是登录状态，忽略接收到的数据
-    if (stateManager.currentState() != WidgetState::LoggingIn) {
-        qDebug() << "当前不是登录状态，忽略接收到的数据";
-        return;
-    }
     //状态一定要用完之后马上恢复，不然就会导致下面的function调用创建窗口实例之后，状态又被设置成默认的了
 
     // 完成后恢复为 Idle 状态
@@ -212,6 +207,9 @@ void Login_Widget::onDataReceived(const QJsonObject &data)
 
         qDebug() << "登录成功，处理缓存和跳转";
 
+        // 断线重连时凭会话令牌恢复会话，不必重新登录
+        tcpClient->setSessionToken(data["token"].toString());
+
         // 登录成功
 //--------------------------------------------------------------------------------------------------
     // Function::handleUserCache(type, username, data);
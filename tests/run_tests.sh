@@ -84,6 +84,21 @@ run_all_tests() {
     echo "运行TcpClient测试..."
     ./TcpClient_test
 
+    echo "运行FrameBuffer测试..."
+    ./FrameBuffer_test
+
+    echo "运行NetWorker测试..."
+    ./NetWorker_test
+
+    echo "运行ReplyDispatcher测试..."
+    ./ReplyDispatcher_test
+
+    echo "运行ReplyCache测试..."
+    ./ReplyCache_test
+
+    echo "运行RecordStore测试..."
+    ./RecordStore_test
+
     echo "运行UserSession测试..."
     ./UserSession_test
 
@@ -99,6 +114,18 @@ run_all_tests() {
     echo "运行DataManager测试..."
     ./DataManager_test
 
+    echo "运行RecordModel测试..."
+    ./RecordModel_test
+
+    echo "运行ServerRouter测试..."
+    ./ServerRouter_test
+
+    # 服务器端测试只在找到 nlohmann/json 时编译
+    if [ -x ./ServerRequest_test ]; then
+        echo "运行ServerRequest测试..."
+        ./ServerRequest_test
+    fi
+
     echo "===================="
     echo "所有测试完成"
 }
@@ -109,7 +136,7 @@ run_specific_test() {
 
     if [ -z "$test_name" ]; then
         echo "错误: 请指定测试名称"
-        echo "可用测试: TcpClient_test, UserSession_test, JsonMessageBuilder_test, StateManager_test, Function_test, DataManager_test"
+        echo "可用测试: TcpClient_test, FrameBuffer_test, NetWorker_test, ReplyDispatcher_test, ReplyCache_test, RecordStore_test, UserSession_test, JsonMessageBuilder_test, StateManager_test, Function_test, DataManager_test, RecordModel_test, ServerRouter_test, ServerRequest_test"
         exit 1
     fi
 
@@ -145,11 +172,19 @@ show_help() {
     echo ""
     echo "测试名称:"
     echo "  TcpClient_test       TCP客户端测试"
+    echo "  FrameBuffer_test     接收缓冲分帧测试"
+    echo "  NetWorker_test       网络线程回复解析测试"
+    echo "  ReplyDispatcher_test 回复分发测试"
+    echo "  ReplyCache_test      回复缓存测试"
+    echo "  RecordStore_test     本地记录库测试"
     echo "  UserSession_test     用户会话测试"
     echo "  JsonMessageBuilder_test JSON消息构建器测试"
     echo "  StateManager_test    状态管理器测试"
     echo "  Function_test        功能函数测试"
     echo "  DataManager_test     数据管理器测试"
+    echo "  RecordModel_test     列表模型测试"
+    echo "  ServerRouter_test    服务器读写分离路由测试"
+    echo "  ServerRequest_test   服务器请求解析测试"
     echo ""
     echo "示例:"
     echo "  $0                    运行所有测试"
@@ -14,10 +14,18 @@ int main(int argc, char *argv[])
     // 定义要运行的测试列表
     QStringList tests = {
         "TcpClient_test",
+        "FrameBuffer_test",
+        "NetWorker_test",
+        "ReplyDispatcher_test",
+        "ReplyCache_test",
+        "RecordStore_test",
         "UserSession_test",
         "JsonMessageBuilder_test",
         "StateManager_test",
-        "DataManager_test"
+        "DataManager_test",
+        "RecordModel_test",
+        "ServerRouter_test",
+        "ServerRequest_test"
     };
 
     for (const QString& test : tests) {
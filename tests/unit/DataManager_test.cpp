@@ -58,6 +58,11 @@ private slots:
     void testExtractDataWithExtraFields();
     void testExtractDataWithNullValues();
 
+    // 服务器回复格式（记录键带序号）测试
+    void testExtractOrderedByIndex();
+    void testExtractIgnoresOtherKeys();
+    void testExtractLargeList();
+
 private:
     DataManager* m_dataManager;
 
@@ -473,6 +478,76 @@ void DataManagerTest::testExtractDataWithNullValues()
     qDebug() << "null值数据提取测试通过";
 }
 
+void DataManagerTest::testExtractOrderedByIndex()
+{
+    QJsonObject reply;
+    reply["reply"] = "successful";
+    for (int i = 1; i <= 12; ++i) {
+        QJsonObject appointment;
+        appointment["patientUsername"] = QString("patient%1").arg(i);
+        appointment["time"] = QString::number(i);
+        reply[QString("appointment_%1").arg(i)] = appointment;
+    }
+
+    QList<DataManager::AppointmentInfo> appointments = m_dataManager->extractAppointments(reply);
+
+    // 按序号排列，而不是按键的字典序（appointment_10 在 appointment_2 之前）
+    QCOMPARE(appointments.size(), 12);
+    for (int i = 0; i < 12; ++i) {
+        QCOMPARE(appointments[i].patientUsername, QString("patient%1").arg(i + 1));
+        QCOMPARE(appointments[i].appointmentKey, QString("appointment_%1").arg(i + 1));
+    }
+
+    qDebug() << "按序号排序测试通过";
+}
+
+void DataManagerTest::testExtractIgnoresOtherKeys()
+{
+    QJsonObject doctor;
+    doctor["username"] = "doctor001";
+    doctor["cost"] = "50";
+
+    QJsonObject reply;
+    reply["reply"] = "successful";
+    reply["doctor_1"] = doctor;
+    reply["doctorInfo"] = doctor;        // 前缀相同但不是记录键
+    reply["doctor_2"] = "not an object";  // 不是对象的跳过
+    reply["watermark"] = "w";
+
+    QList<DataManager::DoctorInfo> doctors = m_dataManager->extractDoctors(reply);
+
+    QCOMPARE(doctors.size(), 1);
+    QCOMPARE(doctors[0].username, QString("doctor001"));
+    QCOMPARE(doctors[0].cost, QString("50"));
+    QVERIFY(doctors[0].name.isEmpty());
+
+    qDebug() << "忽略无关键测试通过";
+}
+
+void DataManagerTest::testExtractLargeList()
+{
+    QJsonObject reply;
+    for (int i = 1; i <= 20000; ++i) {
+        QJsonObject notice;
+        notice["username"] = "patient001";
+        notice["type"] = "patient";
+        notice["message"] = QString("通知%1").arg(i);
+        notice["time"] = "2024-01-15 09:00:00";
+        reply[QString("notice_%1").arg(i)] = notice;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<DataManager::NoticeInfo> notices = m_dataManager->extractNotices(reply);
+    qDebug() << "两万条通知解码耗时(ms):" << timer.elapsed();
+
+    QCOMPARE(notices.size(), 20000);
+    QCOMPARE(notices.first().message, QString("通知1"));
+    QCOMPARE(notices.last().message, QString("通知20000"));
+
+    qDebug() << "大列表解码测试通过";
+}
+
 // 创建测试用数据的辅助方法
 QJsonObject DataManagerTest::createAppointmentJson()
 {
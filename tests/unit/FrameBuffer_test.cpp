@@ -0,0 +1,135 @@
+#include <QtTest/QtTest>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include "../../NetWork/framebuffer.h"
+#include "../config/test_config.h"
+
+class FrameBufferTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // 分帧测试
+    void testSingleFrame();
+    void testCoalescedFrames();
+    void testSplitFrame();
+    void testSplitAcrossManyChunks();
+    void testEmptyFramesSkipped();
+
+    // 边界条件测试
+    void testOverflowDropsBuffer();
+    void testClear();
+};
+
+void FrameBufferTest::initTestCase()
+{
+    qDebug() << "FrameBuffer测试开始";
+}
+
+void FrameBufferTest::cleanupTestCase()
+{
+    qDebug() << "FrameBuffer测试完成";
+}
+
+void FrameBufferTest::testSingleFrame()
+{
+    FrameBuffer buffer;
+    QList<QByteArray> frames = buffer.append("{\"reply\":\"successful\"}\n");
+
+    QCOMPARE(frames.size(), 1);
+    QCOMPARE(frames[0], QByteArray("{\"reply\":\"successful\"}"));
+    QCOMPARE(buffer.pending(), 0);
+}
+
+void FrameBufferTest::testCoalescedFrames()
+{
+    // 查询过程中插进来一条聊天广播，两条回复在同一次读取中到达
+    FrameBuffer buffer;
+    QList<QByteArray> frames = buffer.append(
+        "{\"reply\":\"successful\",\"data\":{\"message\":\"[a] hi\"}}\n"
+        "{\"reply\":\"successful\",\"data\":{\"case_1\":{}}}\n");
+
+    QCOMPARE(frames.size(), 2);
+    QVERIFY(QJsonDocument::fromJson(frames[0]).object()["data"].toObject().contains("message"));
+    QVERIFY(QJsonDocument::fromJson(frames[1]).object()["data"].toObject().contains("case_1"));
+}
+
+void FrameBufferTest::testSplitFrame()
+{
+    FrameBuffer buffer;
+
+    QVERIFY(buffer.append("{\"reply\":\"succ").isEmpty());
+    QCOMPARE(buffer.pending(), 14);
+
+    QList<QByteArray> frames = buffer.append("essful\"}\n{\"reply\"");
+    QCOMPARE(frames.size(), 1);
+    QCOMPARE(frames[0], QByteArray("{\"reply\":\"successful\"}"));
+    QCOMPARE(buffer.pending(), 8);
+}
+
+void FrameBufferTest::testSplitAcrossManyChunks()
+{
+    // 大的病历列表回复分成很多段到达
+    QJsonObject data;
+    for (int i = 1; i <= 500; ++i) {
+        data[QString("case_%1").arg(i)] = QString(100, QChar('x'));
+    }
+    QJsonObject reply;
+    reply["reply"] = "successful";
+    reply["data"] = data;
+    QByteArray bytes = QJsonDocument(reply).toJson(QJsonDocument::Compact) + "\n";
+
+    FrameBuffer buffer;
+    QList<QByteArray> frames;
+    for (int i = 0; i < bytes.size(); i += 1460) {
+        frames += buffer.append(bytes.mid(i, 1460));
+    }
+
+    QCOMPARE(frames.size(), 1);
+    QCOMPARE(QJsonDocument::fromJson(frames[0]).object()["data"].toObject().size(), 500);
+}
+
+void FrameBufferTest::testEmptyFramesSkipped()
+{
+    // 服务器的聊天广播结尾会多带一个换行
+    FrameBuffer buffer;
+    QList<QByteArray> frames = buffer.append("{\"reply\":\"successful\"}\n\n\r\n{\"reply\":\"pong\"}\n");
+
+    QCOMPARE(frames.size(), 2);
+    QCOMPARE(frames[1], QByteArray("{\"reply\":\"pong\"}"));
+}
+
+void FrameBufferTest::testOverflowDropsBuffer()
+{
+    FrameBuffer buffer(16);
+
+    QList<QByteArray> frames = buffer.append("{\"reply\":\"ok\"}\n{\"reply\":\"this one is too long\"");
+    QCOMPARE(frames.size(), 1);
+    QVERIFY(buffer.overflowed());
+    QCOMPARE(buffer.pending(), 0);
+
+    // 下一次读取恢复正常
+    frames = buffer.append("{\"reply\":\"ok\"}\n");
+    QVERIFY(!buffer.overflowed());
+    QCOMPARE(frames.size(), 1);
+}
+
+void FrameBufferTest::testClear()
+{
+    FrameBuffer buffer;
+    buffer.append("{\"reply\":");
+    QVERIFY(buffer.pending() > 0);
+
+    buffer.clear();
+    QCOMPARE(buffer.pending(), 0);
+
+    QList<QByteArray> frames = buffer.append("{\"reply\":\"pong\"}\n");
+    QCOMPARE(frames.size(), 1);
+    QCOMPARE(frames[0], QByteArray("{\"reply\":\"pong\"}"));
+}
+
+QTEST_MAIN(FrameBufferTest)
+#include "FrameBuffer_test.moc"
@@ -0,0 +1,90 @@
+#include <QtTest/QtTest>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include "../../NetWork/networker.h"
+#include "../config/test_config.h"
+
+class NetWorkerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // 回复解析测试
+    void testDecodeMergesData();
+    void testDecodeRequestId();
+    void testDecodeWithoutData();
+    void testDecodeInvalidFrame();
+
+    // 状态测试
+    void testInitialState();
+};
+
+void NetWorkerTest::initTestCase()
+{
+    qDebug() << "NetWorker测试开始";
+}
+
+void NetWorkerTest::cleanupTestCase()
+{
+    qDebug() << "NetWorker测试完成";
+}
+
+void NetWorkerTest::testDecodeMergesData()
+{
+    QJsonObject reply;
+    bool hasId = true;
+    quint64 id = 7;
+    QVERIFY(NetWorker::decode("{\"reply\":\"successful\",\"data\":{\"username\":\"p1\",\"case_1\":{\"main\":\"头痛\"}}}",
+                              reply, hasId, id));
+
+    QCOMPARE(reply["reply"].toString(), QString("successful"));
+    QCOMPARE(reply["username"].toString(), QString("p1"));
+    QCOMPARE(reply["case_1"].toObject()["main"].toString(), QString("头痛"));
+    QVERIFY(!hasId);
+    QCOMPARE(id, quint64(0));
+}
+
+void NetWorkerTest::testDecodeRequestId()
+{
+    QJsonObject reply;
+    bool hasId = false;
+    quint64 id = 0;
+    QVERIFY(NetWorker::decode("{\"reply\":\"pong\",\"id\":42}", reply, hasId, id));
+
+    QVERIFY(hasId);
+    QCOMPARE(id, quint64(42));
+    QCOMPARE(reply["reply"].toString(), QString("pong"));
+    QVERIFY(!reply.contains("id"));
+}
+
+void NetWorkerTest::testDecodeWithoutData()
+{
+    QJsonObject reply;
+    bool hasId = false;
+    quint64 id = 0;
+    QVERIFY(NetWorker::decode("{\"reply\":\"failed\",\"data\":\"oops\"}", reply, hasId, id));
+
+    QCOMPARE(reply.size(), 1);
+    QCOMPARE(reply["reply"].toString(), QString("failed"));
+}
+
+void NetWorkerTest::testDecodeInvalidFrame()
+{
+    QJsonObject reply;
+    bool hasId = false;
+    quint64 id = 0;
+    QVERIFY(!NetWorker::decode("{\"reply\":\"succ", reply, hasId, id));
+    QVERIFY(!NetWorker::decode("[1,2,3]", reply, hasId, id));
+}
+
+void NetWorkerTest::testInitialState()
+{
+    NetWorker worker;
+    QCOMPARE(worker.state(), QAbstractSocket::UnconnectedState);
+}
+
+QTEST_MAIN(NetWorkerTest)
+#include "NetWorker_test.moc"
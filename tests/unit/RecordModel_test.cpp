@@ -0,0 +1,213 @@
+#include <QtTest/QtTest>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include "../../Fun./RecordModel.h"
+#include "../config/test_config.h"
+
+class RecordModelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    // 取值测试
+    void testRecordsIn();
+    void testDataAndHeader();
+    void testFormatIsLazy();
+
+    // 增量更新测试
+    void testSyncInsertsOnlyNewRows();
+    void testSyncUpdatesOnlyChangedRows();
+    void testSyncRemovesMissingRows();
+    void testUpsertAndRemove();
+    void testMergeKeepsMissingFields();
+    void testLargeSync();
+
+private:
+    static QJsonObject doctor(const QString &username, const QString &cost);
+
+    RecordModel *m_model;
+    int m_formatted;  // 格式化函数被调用的次数
+};
+
+void RecordModelTest::initTestCase()
+{
+    qDebug() << "RecordModel测试开始";
+}
+
+void RecordModelTest::cleanupTestCase()
+{
+    qDebug() << "RecordModel测试完成";
+}
+
+void RecordModelTest::init()
+{
+    m_formatted = 0;
+    m_model = new RecordModel({
+        { "医生用户名", "username", nullptr },
+        { "费用", "cost", nullptr },
+        { "出诊时间", QString(), [this](const QJsonObject &d) {
+              ++m_formatted;
+              return d["begin"].toString() + "-" + d["end"].toString();
+          } },
+    }, [](const QJsonObject &d) { return d["username"].toString(); });
+}
+
+void RecordModelTest::cleanup()
+{
+    delete m_model;
+}
+
+QJsonObject RecordModelTest::doctor(const QString &username, const QString &cost)
+{
+    return QJsonObject{ { "username", username }, { "cost", cost }, { "begin", "8" }, { "end", "17" } };
+}
+
+void RecordModelTest::testRecordsIn()
+{
+    QJsonObject reply{ { "reply", "successful" }, { "doctor_1", doctor("d1", "20") },
+                       { "doctor_2", doctor("d2", "30") }, { "watermark", "w" } };
+    QCOMPARE(RecordModel::recordsIn(reply, "doctor_").size(), 2);
+    QCOMPARE(RecordModel::recordsIn(reply, "patient_").size(), 0);
+}
+
+void RecordModelTest::testDataAndHeader()
+{
+    m_model->sync({ doctor("d1", "20") });
+    QCOMPARE(m_model->rowCount(), 1);
+    QCOMPARE(m_model->columnCount(), 3);
+    QCOMPARE(m_model->headerData(1, Qt::Horizontal).toString(), QString("费用"));
+    QCOMPARE(m_model->data(m_model->index(0, 1)).toString(), QString("20"));
+    QCOMPARE(m_model->data(m_model->index(0, 2)).toString(), QString("8-17"));
+    QCOMPARE(m_model->data(m_model->index(0, 0), RecordModel::KeyRole).toString(), QString("d1"));
+    QCOMPARE(m_model->rowOf("d1"), 0);
+    QCOMPARE(m_model->rowOf("d9"), -1);
+}
+
+void RecordModelTest::testFormatIsLazy()
+{
+    QList<QJsonObject> records;
+    for (int i = 0; i < 1000; ++i) {
+        records.append(doctor(QString("d%1").arg(i), "20"));
+    }
+    m_model->sync(records);
+    QCOMPARE(m_formatted, 0);
+
+    m_model->data(m_model->index(500, 2));
+    QCOMPARE(m_formatted, 1);
+}
+
+void RecordModelTest::testSyncInsertsOnlyNewRows()
+{
+    m_model->sync({ doctor("d1", "20"), doctor("d2", "30") });
+
+    QSignalSpy inserted(m_model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy changed(m_model, &QAbstractItemModel::dataChanged);
+    QSignalSpy reset(m_model, &QAbstractItemModel::modelReset);
+    m_model->sync({ doctor("d1", "20"), doctor("d2", "30"), doctor("d3", "40") });
+
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted[0][1].toInt(), 2);
+    QCOMPARE(inserted[0][2].toInt(), 2);
+    QCOMPARE(changed.count(), 0);
+    QCOMPARE(reset.count(), 0);
+}
+
+void RecordModelTest::testSyncUpdatesOnlyChangedRows()
+{
+    m_model->sync({ doctor("d1", "20"), doctor("d2", "30"), doctor("d3", "40") });
+
+    QSignalSpy changed(m_model, &QAbstractItemModel::dataChanged);
+    QSignalSpy inserted(m_model, &QAbstractItemModel::rowsInserted);
+    m_model->sync({ doctor("d1", "20"), doctor("d2", "35"), doctor("d3", "40") });
+
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed[0][0].value<QModelIndex>().row(), 1);
+    QCOMPARE(inserted.count(), 0);
+    QCOMPARE(m_model->recordAt(1)["cost"].toString(), QString("35"));
+}
+
+void RecordModelTest::testSyncRemovesMissingRows()
+{
+    m_model->sync({ doctor("d1", "20"), doctor("d2", "30"), doctor("d3", "40"), doctor("d4", "50") });
+
+    QSignalSpy removed(m_model, &QAbstractItemModel::rowsRemoved);
+    m_model->sync({ doctor("d1", "20"), doctor("d4", "50") });
+
+    // 相邻的两行合成一次删除
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed[0][1].toInt(), 1);
+    QCOMPARE(removed[0][2].toInt(), 2);
+    QCOMPARE(m_model->rowCount(), 2);
+    QCOMPARE(m_model->rowOf("d4"), 1);
+    QCOMPARE(m_model->keyAt(1), QString("d4"));
+}
+
+void RecordModelTest::testUpsertAndRemove()
+{
+    m_model->upsert(doctor("d1", "20"));
+    m_model->upsert(doctor("d2", "30"));
+    m_model->upsert(doctor("d1", "25"));
+    QCOMPARE(m_model->rowCount(), 2);
+    QCOMPARE(m_model->recordAt(0)["cost"].toString(), QString("25"));
+
+    m_model->remove("d1");
+    QCOMPARE(m_model->rowCount(), 1);
+    QCOMPARE(m_model->rowOf("d2"), 0);
+
+    m_model->remove("d9");
+    QCOMPARE(m_model->rowCount(), 1);
+
+    m_model->clear();
+    QCOMPARE(m_model->rowCount(), 0);
+    QCOMPARE(m_model->rowOf("d2"), -1);
+}
+
+void RecordModelTest::testMergeKeepsMissingFields()
+{
+    m_model->upsert(doctor("d1", "20"));
+    QSignalSpy changed(m_model, &QAbstractItemModel::dataChanged);
+
+    // 变更推送只带键和改动的字段，没给出的费用保持原值
+    m_model->merge(QJsonObject{ { "username", "d1" }, { "begin", "9" } });
+    QCOMPARE(m_model->rowCount(), 1);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(m_model->recordAt(0)["cost"].toString(), QString("20"));
+    QCOMPARE(m_model->recordAt(0)["begin"].toString(), QString("9"));
+
+    // 内容没变时不发通知
+    m_model->merge(QJsonObject{ { "username", "d1" }, { "begin", "9" } });
+    QCOMPARE(changed.count(), 1);
+
+    m_model->merge(doctor("d2", "30"));
+    QCOMPARE(m_model->rowCount(), 2);
+    QCOMPARE(m_model->rowOf("d2"), 1);
+}
+
+void RecordModelTest::testLargeSync()
+{
+    QList<QJsonObject> records;
+    for (int i = 0; i < 100000; ++i) {
+        records.append(doctor(QString("d%1").arg(i), "20"));
+    }
+    m_model->sync(records);
+    QCOMPARE(m_model->rowCount(), 100000);
+
+    // 再同步一遍只改一行，只有这一行收到通知
+    records[99999]["cost"] = "99";
+    QSignalSpy changed(m_model, &QAbstractItemModel::dataChanged);
+    QElapsedTimer timer;
+    timer.start();
+    m_model->sync(records);
+    qDebug() << "十万行增量同步耗时(ms):" << timer.elapsed();
+
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed[0][0].value<QModelIndex>().row(), 99999);
+}
+
+QTEST_MAIN(RecordModelTest)
+#include "RecordModel_test.moc"
@@ -0,0 +1,194 @@
+#include <QtTest/QtTest>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include "../../NetWork/recordstore.h"
+#include "../../Fun./DataManager.h"
+#include "../config/test_config.h"
+
+class RecordStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    // 同步与合并测试
+    void testKindFor();
+    void testFirstSync();
+    void testDeltaMergedById();
+    void testOldServerNotMerged();
+    void testReplyReadableByDataManager();
+
+    // 持久化测试
+    void testPersistAcrossOpen();
+    void testTornTailTruncated();
+    void testCompaction();
+
+private:
+    static QJsonObject caseRow(qint64 id, const QString &diagnose);
+    static QJsonObject syncReply(const QString &watermark, const QList<QJsonObject> &rows);
+    void reopen();
+
+    QTemporaryDir m_dir;
+};
+
+void RecordStoreTest::initTestCase()
+{
+    qDebug() << "RecordStore测试开始";
+    QVERIFY(m_dir.isValid());
+}
+
+void RecordStoreTest::cleanupTestCase()
+{
+    qDebug() << "RecordStore测试完成";
+}
+
+void RecordStoreTest::init()
+{
+    reopen();
+    RecordStore::instance().clear();
+}
+
+QJsonObject RecordStoreTest::caseRow(qint64 id, const QString &diagnose)
+{
+    return QJsonObject{ { "id", id }, { "patientUsername", "p1" }, { "doctorUsername", "d1" },
+                        { "date", "2026-10-19" }, { "time", "9" }, { "main", "头痛" },
+                        { "now", "" }, { "past", "" }, { "check", "" }, { "diagnose", diagnose } };
+}
+
+QJsonObject RecordStoreTest::syncReply(const QString &watermark, const QList<QJsonObject> &rows)
+{
+    QJsonObject reply{ { "reply", "successful" }, { "watermark", watermark } };
+    for (int i = 0; i < rows.size(); ++i) {
+        reply["case_" + QString::number(i + 1)] = rows[i];
+    }
+    return reply;
+}
+
+// 重新指定目录即丢弃内存中的内容，再次打开时从文件载入
+void RecordStoreTest::reopen()
+{
+    RecordStore::instance().setDirectory(m_dir.path());
+    RecordStore::instance().open("patient", "p1");
+}
+
+void RecordStoreTest::testKindFor()
+{
+    QCOMPARE(RecordStore::kindFor("queryCaseList"), QString("case"));
+    QCOMPARE(RecordStore::kindFor("queryAdviceList"), QString("advice"));
+    QVERIFY(RecordStore::kindFor("queryDoctorList").isEmpty());
+}
+
+void RecordStoreTest::testFirstSync()
+{
+    RecordStore &store = RecordStore::instance();
+    QVERIFY(!store.hasSynced("case"));
+
+    QCOMPARE(store.merge("case", syncReply("2026-10-19 09:00:00.000", { caseRow(1, "感冒"), caseRow(2, "偏头痛") })), 2);
+    QVERIFY(store.hasSynced("case"));
+    QVERIFY(!store.hasSynced("advice"));
+    QCOMPARE(store.watermark("case"), QString("2026-10-19 09:00:00.000"));
+    QCOMPARE(store.records("case").size(), 2);
+
+    // 没有记录也算同步过，之后只要增量
+    QCOMPARE(store.merge("advice", syncReply("", {})), 0);
+    QVERIFY(store.hasSynced("advice"));
+}
+
+void RecordStoreTest::testDeltaMergedById()
+{
+    RecordStore &store = RecordStore::instance();
+    store.merge("case", syncReply("2026-10-19 09:00:00.000", { caseRow(1, "感冒"), caseRow(2, "偏头痛") }));
+
+    // 重叠部分重复发来的行不算改动
+    QCOMPARE(store.merge("case", syncReply("2026-10-19 09:00:00.000", { caseRow(2, "偏头痛") })), 0);
+
+    // 改了一行、新增一行
+    QCOMPARE(store.merge("case", syncReply("2026-10-19 10:00:00.000", { caseRow(2, "紧张性头痛"), caseRow(3, "失眠") })), 2);
+    const QList<QJsonObject> rows = store.records("case");
+    QCOMPARE(rows.size(), 3);
+    QCOMPARE(rows[1]["diagnose"].toString(), QString("紧张性头痛"));
+    QCOMPARE(rows[2]["diagnose"].toString(), QString("失眠"));
+    QCOMPARE(store.watermark("case"), QString("2026-10-19 10:00:00.000"));
+}
+
+void RecordStoreTest::testOldServerNotMerged()
+{
+    QJsonObject reply{ { "reply", "successful" }, { "case_1", caseRow(1, "感冒") } };
+    QCOMPARE(RecordStore::instance().merge("case", reply), -1);
+    QVERIFY(!RecordStore::instance().hasSynced("case"));
+}
+
+void RecordStoreTest::testReplyReadableByDataManager()
+{
+    RecordStore::instance().merge("case", syncReply("w1", { caseRow(1, "感冒"), caseRow(2, "偏头痛") }));
+
+    QList<DataManager::CaseInfo> cases = DataManager::instance().extractCases(RecordStore::instance().reply("case"));
+    QCOMPARE(cases.size(), 2);
+    QCOMPARE(cases[0].doctorUsername, QString("d1"));
+}
+
+void RecordStoreTest::testPersistAcrossOpen()
+{
+    RecordStore::instance().merge("case", syncReply("w1", { caseRow(1, "感冒") }));
+    RecordStore::instance().merge("case", syncReply("w2", { caseRow(1, "流感"), caseRow(5, "鼻炎") }));
+
+    reopen();
+    RecordStore &store = RecordStore::instance();
+    QVERIFY(store.hasSynced("case"));
+    QCOMPARE(store.watermark("case"), QString("w2"));
+    const QList<QJsonObject> rows = store.records("case");
+    QCOMPARE(rows.size(), 2);
+    QCOMPARE(rows[0]["diagnose"].toString(), QString("流感"));
+
+    // 换一个用户是另一个库
+    store.open("doctor", "d1");
+    QVERIFY(!store.hasSynced("case"));
+}
+
+void RecordStoreTest::testTornTailTruncated()
+{
+    RecordStore::instance().merge("case", syncReply("w1", { caseRow(1, "感冒") }));
+    const QString path = m_dir.filePath("patient_p1_records.log");
+    const qint64 good = QFileInfo(path).size();
+    QVERIFY(good > 0);
+
+    // 模拟追加到一半时退出：长度说有 100 字节，实际只写了 3 字节
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+    file.write(QByteArray("\x00\x00\x00\x64" "abc", 7));
+    file.close();
+
+    reopen();
+    QCOMPARE(RecordStore::instance().records("case").size(), 1);
+    QCOMPARE(QFileInfo(path).size(), good);
+
+    // 截掉之后还能继续追加
+    RecordStore::instance().merge("case", syncReply("w2", { caseRow(2, "失眠") }));
+    reopen();
+    QCOMPARE(RecordStore::instance().records("case").size(), 2);
+}
+
+void RecordStoreTest::testCompaction()
+{
+    RecordStore &store = RecordStore::instance();
+    for (int i = 0; i <= RecordStore::compactAfter + 1; ++i) {
+        store.merge("case", syncReply(QString("w%1").arg(i), { caseRow(1, QString("第%1次").arg(i)) }));
+    }
+    const QString path = m_dir.filePath("patient_p1_records.log");
+    const qint64 compacted = QFileInfo(path).size();
+
+    reopen();
+    QCOMPARE(RecordStore::instance().records("case").size(), 1);
+    QCOMPARE(RecordStore::instance().records("case")[0]["diagnose"].toString(),
+             QString("第%1次").arg(RecordStore::compactAfter + 1));
+    QCOMPARE(RecordStore::instance().watermark("case"), QString("w%1").arg(RecordStore::compactAfter + 1));
+
+    // 重写后日志只剩快照和之后追加的少数几批
+    QVERIFY(compacted < qint64(RecordStore::compactAfter) * 64);
+}
+
+QTEST_MAIN(RecordStoreTest)
+#include "RecordStore_test.moc"
@@ -0,0 +1,141 @@
+#include <QtTest/QtTest>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include "../../NetWork/replycache.h"
+#include "../config/test_config.h"
+
+class ReplyCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    // 缓存键与有效期测试
+    void testOnlyListedCommandsCached();
+    void testKeyDependsOnParams();
+    void testStoreAndLookup();
+    void testFreshAndStale();
+
+    // 失效与持久化测试
+    void testInvalidateOnWrite();
+    void testPersistAcrossInstances();
+    void testCorruptFileIgnored();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+void ReplyCacheTest::initTestCase()
+{
+    qDebug() << "ReplyCache测试开始";
+    QVERIFY(m_dir.isValid());
+}
+
+void ReplyCacheTest::cleanupTestCase()
+{
+    qDebug() << "ReplyCache测试完成";
+}
+
+void ReplyCacheTest::init()
+{
+    ReplyCache::instance().setPath(m_dir.filePath("reply_cache.cbor"));
+    ReplyCache::instance().clear();
+}
+
+void ReplyCacheTest::testOnlyListedCommandsCached()
+{
+    QVERIFY(ReplyCache::ttl("queryDoctorList") > 0);
+    QVERIFY(ReplyCache::ttl("queryDoctorInfo") > 0);
+    QVERIFY(ReplyCache::ttl("queryNoticeList") > 0);
+    QCOMPARE(ReplyCache::ttl("queryCaseList"), 0);
+    QCOMPARE(ReplyCache::ttl("modifyDoctorInfo"), 0);
+}
+
+void ReplyCacheTest::testKeyDependsOnParams()
+{
+    QJsonObject morning{ { "time", "8" } }, evening{ { "time", "20" } };
+    QVERIFY(ReplyCache::key("queryDoctorList", morning) != ReplyCache::key("queryDoctorList", evening));
+
+    // 参数相同、插入顺序不同时键相同
+    QJsonObject a, b;
+    a["username"] = "p1", a["type"] = "patient";
+    b["type"] = "patient", b["username"] = "p1";
+    QCOMPARE(ReplyCache::key("queryNoticeList", a), ReplyCache::key("queryNoticeList", b));
+}
+
+void ReplyCacheTest::testStoreAndLookup()
+{
+    QJsonObject params{ { "time", "8" } };
+    QJsonObject reply{ { "reply", "successful" }, { "doctor_1", QJsonObject{ { "name", "张三" } } } };
+
+    ReplyCache::Entry entry;
+    QVERIFY(!ReplyCache::instance().lookup("queryDoctorList", params, entry));
+
+    ReplyCache::instance().store("queryDoctorList", params, reply, "abc");
+    QVERIFY(ReplyCache::instance().lookup("queryDoctorList", params, entry));
+    QCOMPARE(entry.reply, reply);
+    QCOMPARE(entry.version, QString("abc"));
+    QVERIFY(!ReplyCache::instance().lookup("queryDoctorList", QJsonObject{ { "time", "9" } }, entry));
+}
+
+void ReplyCacheTest::testFreshAndStale()
+{
+    ReplyCache::Entry entry;
+    entry.storedAt = QDateTime::currentMSecsSinceEpoch();
+    QVERIFY(ReplyCache::instance().isFresh("queryNoticeList", entry));
+
+    entry.storedAt -= ReplyCache::ttl("queryNoticeList") + 1;
+    QVERIFY(!ReplyCache::instance().isFresh("queryNoticeList", entry));
+}
+
+void ReplyCacheTest::testInvalidateOnWrite()
+{
+    QJsonObject params{ { "doctorUsername", "d1" } };
+    ReplyCache::instance().store("queryDoctorInfo", params, QJsonObject{ { "reply", "successful" } }, "v1");
+    ReplyCache::instance().store("queryNoticeList", QJsonObject(), QJsonObject{ { "reply", "successful" } }, "v2");
+
+    ReplyCache::instance().invalidateFor("queryCaseList");
+    QCOMPARE(ReplyCache::instance().size(), 2);
+
+    ReplyCache::instance().invalidateFor("modifyDoctorInfo");
+    ReplyCache::Entry entry;
+    QVERIFY(!ReplyCache::instance().lookup("queryDoctorInfo", params, entry));
+    QVERIFY(ReplyCache::instance().lookup("queryNoticeList", QJsonObject(), entry));
+}
+
+void ReplyCacheTest::testPersistAcrossInstances()
+{
+    QJsonObject params{ { "time", "25" } };
+    QJsonObject reply{ { "reply", "successful" }, { "doctor_1", QJsonObject{ { "cost", "20" } } } };
+    ReplyCache::instance().store("queryDoctorList", params, reply, "v3");
+    ReplyCache::instance().save();
+
+    // 重新指定路径即丢弃内存中的缓存，下次查找时从文件载入
+    ReplyCache::instance().setPath(m_dir.filePath("reply_cache.cbor"));
+    QCOMPARE(ReplyCache::instance().size(), 0);
+
+    ReplyCache::Entry entry;
+    QVERIFY(ReplyCache::instance().lookup("queryDoctorList", params, entry));
+    QCOMPARE(entry.reply, reply);
+    QCOMPARE(entry.version, QString("v3"));
+}
+
+void ReplyCacheTest::testCorruptFileIgnored()
+{
+    QString path = m_dir.filePath("corrupt.cbor");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not cbor at all");
+    file.close();
+
+    ReplyCache::instance().setPath(path);
+    ReplyCache::Entry entry;
+    QVERIFY(!ReplyCache::instance().lookup("queryDoctorList", QJsonObject(), entry));
+    QCOMPARE(ReplyCache::instance().size(), 0);
+}
+
+QTEST_MAIN(ReplyCacheTest)
+#include "ReplyCache_test.moc"
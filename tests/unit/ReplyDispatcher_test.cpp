@@ -0,0 +1,180 @@
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QJsonObject>
+#include "../../NetWork/replydispatcher.h"
+#include "../../Instance/StateManager.h"
+#include "../config/test_config.h"
+
+class ReplyDispatcherTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    // 按请求分发测试
+    void testTrackedReplyGoesToStateAtSend();
+    void testExpectedReplyGoesToHandler();
+    void testCancelledRequestIsDropped();
+    void testFailAll();
+
+    // 路由登记测试
+    void testLaterRouteReplacesEarlier();
+    void testRouteRemovedWhenReceiverDestroyed();
+
+    // 推送测试
+    void testPushRoutedByReply();
+    void testPushFallsBackToCurrentState();
+
+private:
+    quint64 m_nextId;
+};
+
+void ReplyDispatcherTest::initTestCase()
+{
+    qDebug() << "ReplyDispatcher测试开始";
+
+    if (!QApplication::instance()) {
+        int argc = 0;
+        char* argv[] = { nullptr };
+        new QApplication(argc, argv);
+    }
+    m_nextId = 1;
+}
+
+void ReplyDispatcherTest::cleanupTestCase()
+{
+    StateManager::instance().setState(WidgetState::Idle);
+    qDebug() << "ReplyDispatcher测试完成";
+}
+
+void ReplyDispatcherTest::init()
+{
+    ReplyDispatcher::instance().failAll("disconnected");
+    StateManager::instance().setState(WidgetState::Idle);
+}
+
+void ReplyDispatcherTest::testTrackedReplyGoesToStateAtSend()
+{
+    QObject caseList, adviceList;
+    int cases = 0, advices = 0;
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientCaseList, &caseList,
+                                      [&](const QJsonObject &) { ++cases; });
+    ReplyDispatcher::instance().route(WidgetState::waitRecivePatientAdviceList, &adviceList,
+                                      [&](const QJsonObject &) { ++advices; });
+
+    // 两个窗口先后发出请求，回复到达时全局状态已经变了
+    quint64 caseId = m_nextId++, adviceId = m_nextId++;
+    ReplyDispatcher::instance().track(caseId, WidgetState::waitRecivePatientCaseList);
+    ReplyDispatcher::instance().track(adviceId, WidgetState::waitRecivePatientAdviceList);
+
+    QVERIFY(ReplyDispatcher::instance().finish(caseId, QJsonObject{ { "reply", "successful" } }));
+    QCOMPARE(cases, 1);
+    QCOMPARE(advices, 0);
+
+    QVERIFY(ReplyDispatcher::instance().finish(adviceId, QJsonObject{ { "reply", "successful" } }));
+    QCOMPARE(cases, 1);
+    QCOMPARE(advices, 1);
+
+    // 同一请求的回复只分发一次
+    QVERIFY(!ReplyDispatcher::instance().finish(caseId, QJsonObject{ { "reply", "successful" } }));
+    QCOMPARE(cases, 1);
+}
+
+void ReplyDispatcherTest::testExpectedReplyGoesToHandler()
+{
+    QObject context;
+    QJsonObject received;
+    quint64 id = m_nextId++;
+    ReplyDispatcher::instance().expect(id, &context, [&](const QJsonObject &reply) { received = reply; });
+    QCOMPARE(ReplyDispatcher::instance().pending(), 1);
+
+    ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "pong" } });
+    QCOMPARE(received["reply"].toString(), QString("pong"));
+    QCOMPARE(ReplyDispatcher::instance().pending(), 0);
+}
+
+void ReplyDispatcherTest::testCancelledRequestIsDropped()
+{
+    int calls = 0;
+    quint64 id = m_nextId++;
+    ReplyDispatcher::instance().expect(id, nullptr, [&](const QJsonObject &) { ++calls; });
+    ReplyDispatcher::instance().cancel(id);
+
+    QVERIFY(!ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "pong" } }));
+    QCOMPARE(calls, 0);
+}
+
+void ReplyDispatcherTest::testFailAll()
+{
+    QString reply;
+    ReplyDispatcher::instance().expect(m_nextId++, nullptr, [&](const QJsonObject &r) { reply = r["reply"].toString(); });
+    ReplyDispatcher::instance().track(m_nextId++, WidgetState::waitReciveDoctorCaseList);
+
+    ReplyDispatcher::instance().failAll("disconnected");
+    QCOMPARE(reply, QString("disconnected"));
+    QCOMPARE(ReplyDispatcher::instance().pending(), 0);
+}
+
+void ReplyDispatcherTest::testLaterRouteReplacesEarlier()
+{
+    QObject first, second;
+    int firstCalls = 0, secondCalls = 0;
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorCase, &first,
+                                      [&](const QJsonObject &) { ++firstCalls; });
+    ReplyDispatcher::instance().route(WidgetState::waitReciveDoctorCase, &second,
+                                      [&](const QJsonObject &) { ++secondCalls; });
+
+    quint64 id = m_nextId++;
+    ReplyDispatcher::instance().track(id, WidgetState::waitReciveDoctorCase);
+    ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "successful" } });
+
+    QCOMPARE(firstCalls, 0);
+    QCOMPARE(secondCalls, 1);
+}
+
+void ReplyDispatcherTest::testRouteRemovedWhenReceiverDestroyed()
+{
+    int calls = 0;
+    QObject *receiver = new QObject;
+    ReplyDispatcher::instance().route(WidgetState::waitReciveAdminChart, receiver,
+                                      [&](const QJsonObject &) { ++calls; });
+    delete receiver;
+
+    quint64 id = m_nextId++;
+    ReplyDispatcher::instance().track(id, WidgetState::waitReciveAdminChart);
+    QVERIFY(!ReplyDispatcher::instance().finish(id, QJsonObject{ { "reply", "successful" } }));
+    QCOMPARE(calls, 0);
+}
+
+void ReplyDispatcherTest::testPushRoutedByReply()
+{
+    QObject noticeList, chat;
+    int notices = 0, chats = 0;
+    ReplyDispatcher::instance().routePush("notice", &noticeList, [&](const QJsonObject &) { ++notices; });
+    ReplyDispatcher::instance().route(WidgetState::waitdie_6, &chat, [&](const QJsonObject &) { ++chats; });
+    StateManager::instance().setState(WidgetState::waitdie_6);
+
+    QVERIFY(ReplyDispatcher::instance().push(QJsonObject{ { "reply", "notice" } }));
+    QCOMPARE(notices, 1);
+    QCOMPARE(chats, 0);
+}
+
+void ReplyDispatcherTest::testPushFallsBackToCurrentState()
+{
+    QObject chat;
+    int chats = 0;
+    ReplyDispatcher::instance().route(WidgetState::waitdie_7, &chat, [&](const QJsonObject &) { ++chats; });
+
+    // 当前状态没有处理者时丢弃
+    QVERIFY(!ReplyDispatcher::instance().push(QJsonObject{ { "reply", "successful" } }));
+
+    StateManager::instance().setState(WidgetState::waitdie_7);
+    QVERIFY(ReplyDispatcher::instance().push(QJsonObject{ { "reply", "successful" } }));
+    QCOMPARE(chats, 1);
+}
+
+QTEST_MAIN(ReplyDispatcherTest)
+#include "ReplyDispatcher_test.moc"
@@ -0,0 +1,76 @@
+#include <QtTest/QtTest>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include "../../Server/request.h"
+#include "../config/test_config.h"
+
+// 服务器解析请求帧：客户端发来的字段值原样交给处理函数
+class ServerRequestTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // 解析测试
+    void testWatermarkRoundTrip();
+    void testWhitespaceOutsideStrings();
+    void testEmptyAndMalformedFrames();
+
+private:
+    // 与客户端 TcpClient 发出的帧格式相同
+    static std::string frame(const QString &command, const QJsonObject &data);
+};
+
+void ServerRequestTest::initTestCase()
+{
+    qDebug() << "ServerRequest测试开始";
+}
+
+void ServerRequestTest::cleanupTestCase()
+{
+    qDebug() << "ServerRequest测试完成";
+}
+
+std::string ServerRequestTest::frame(const QString &command, const QJsonObject &data)
+{
+    QJsonObject request{ { "command", command }, { "data", data }, { "id", 7 } };
+    return QJsonDocument(request).toJson(QJsonDocument::Compact).toStdString() + "\r";
+}
+
+void ServerRequestTest::testWatermarkRoundTrip()
+{
+    // 上次回复的 watermark 是 MySQL 的 DATETIME，中间有空格；下一次同步原样作为 since 发回
+    const QString watermark = "2026-10-19 07:13:13.123";
+    nlohmann::json request;
+    QCOMPARE(parse_frame(frame("queryCaseList", QJsonObject{ { "username", "p1" }, { "type", "patient" },
+                                                             { "since", watermark } }), request), 0);
+
+    const nlohmann::json *data;
+    QCOMPARE(get_json(data, request, "data"), 0);
+    std::string_view since;
+    QCOMPARE(get_json(since, *data, "since"), 0);
+    QCOMPARE(QString::fromStdString(std::string(since)), watermark);
+    QVERIFY(is_watermark(since));
+    QVERIFY(!is_watermark("2026-10-19' OR '1"));
+}
+
+void ServerRequestTest::testWhitespaceOutsideStrings()
+{
+    nlohmann::json request;
+    QCOMPARE(parse_frame(" { \"command\" : \"chat\", \"data\" : { \"message\" : \"hello world\" } }\r", request), 0);
+    QCOMPARE(QString::fromStdString(request["command"].get<std::string>()), QString("chat"));
+    QCOMPARE(QString::fromStdString(request["data"]["message"].get<std::string>()), QString("hello world"));
+}
+
+void ServerRequestTest::testEmptyAndMalformedFrames()
+{
+    nlohmann::json request;
+    QCOMPARE(parse_frame("", request), 1);
+    QCOMPARE(parse_frame(" \r", request), 1);
+    QCOMPARE(parse_frame("{\"command\":", request), 2);
+}
+
+QTEST_MAIN(ServerRequestTest)
+#include "ServerRequest_test.moc"
@@ -0,0 +1,164 @@
+#include <QtTest/QtTest>
+#include <map>
+#include <thread>
+#include "../../Server/router.h"
+#include "../config/test_config.h"
+
+// 替身数据库：按主机名区分主库和副本，记录在自己上执行过的语句；down 时连不上、执行失败
+struct StandInDb
+{
+    bool down = false;
+    std::vector<std::string> executed;
+};
+
+struct StandInDriver
+{
+    using handle = StandInDb*;
+    static std::map<std::string, StandInDb> instances;
+
+    static StandInDb *connect(const db_endpoint &e, const char *, const char *, const char *, std::string &error)
+    {
+        StandInDb &db = instances[e.host];
+        if(db.down) return error = "can't connect to " + e.host, nullptr;
+        return &db;
+    }
+    static void close(StandInDb *) { }
+};
+std::map<std::string, StandInDb> StandInDriver::instances;
+
+using StandInRouter = basic_db_router<StandInDriver>;
+
+// 服务器读写分离：对两个替身实例检查读写各自落在哪个库上
+class ServerRouterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    // 路由测试
+    void testReadsGoToReplica();
+    void testWritesGoToPrimary();
+    void testStickyWindow();
+    void testReplicaFailureFallsBackToPrimary();
+    void testUnreachableReplicaSkipped();
+
+private:
+    static constexpr int stickyMs = 50;
+
+    // 与服务器 execute_sql 相同的调用方式，返回执行该语句的实例
+    static std::string run(StandInRouter &router, const std::string &sql);
+    static bool open(StandInRouter &router);
+};
+
+void ServerRouterTest::initTestCase()
+{
+    qDebug() << "ServerRouter测试开始";
+}
+
+void ServerRouterTest::cleanupTestCase()
+{
+    qDebug() << "ServerRouter测试完成";
+}
+
+void ServerRouterTest::init()
+{
+    StandInDriver::instances.clear();
+    // 最近写入时间按线程记录，上一个测试的写入不能落进本测试的粘滞窗口
+    QTest::qSleep(stickyMs * 2);
+}
+
+std::string ServerRouterTest::run(StandInRouter &router, const std::string &sql)
+{
+    bool ok;
+    StandInRouter::lease conn = router.execute(is_write_sql(sql), [&](StandInDb *db)
+    {
+        if(db->down) return false;
+        return db->executed.push_back(sql), true;
+    }, ok);
+    if(!ok) return "";
+    for(auto &[host, db] : StandInDriver::instances)
+        if(&db == static_cast<StandInDb*>(conn)) return host;
+    return "";
+}
+
+bool ServerRouterTest::open(StandInRouter &router)
+{
+    std::string error;
+    return router.open({ "primary", 3306 }, parse_endpoints("replica:3307"), "user", "password", "db", 2, error);
+}
+
+void ServerRouterTest::testReadsGoToReplica()
+{
+    StandInRouter router{ std::chrono::milliseconds(stickyMs) };
+    QVERIFY(open(router));
+    QCOMPARE(router.replica_count(), size_t(1));
+
+    QCOMPARE(QString::fromStdString(run(router, "select * from patient")), QString("replica"));
+    QCOMPARE(QString::fromStdString(run(router, " (select 1)")), QString("replica"));
+    QVERIFY(StandInDriver::instances["primary"].executed.empty());
+}
+
+void ServerRouterTest::testWritesGoToPrimary()
+{
+    StandInRouter router{ std::chrono::milliseconds(stickyMs) };
+    QVERIFY(open(router));
+
+    QCOMPARE(QString::fromStdString(run(router, "insert into chat values('a')")), QString("primary"));
+    QCOMPARE(QString::fromStdString(run(router, "UPDATE appointment set state = 1")), QString("primary"));
+    QCOMPARE(QString::fromStdString(run(router, "delete from notice")), QString("primary"));
+    QVERIFY(StandInDriver::instances["replica"].executed.empty());
+}
+
+void ServerRouterTest::testStickyWindow()
+{
+    StandInRouter router{ std::chrono::milliseconds(stickyMs) };
+    QVERIFY(open(router));
+
+    // 写入后窗口内的读走主库，读到刚写的数据
+    QCOMPARE(QString::fromStdString(run(router, "insert into chat values('a')")), QString("primary"));
+    QCOMPARE(QString::fromStdString(run(router, "select * from chat")), QString("primary"));
+
+    // 其他线程(其他连接)不受这次写入影响
+    std::string other;
+    std::thread([&] { other = run(router, "select * from chat"); }).join();
+    QCOMPARE(QString::fromStdString(other), QString("replica"));
+
+    QTest::qSleep(stickyMs * 2);
+    QCOMPARE(QString::fromStdString(run(router, "select * from chat")), QString("replica"));
+}
+
+void ServerRouterTest::testReplicaFailureFallsBackToPrimary()
+{
+    StandInRouter router{ std::chrono::milliseconds(stickyMs) };
+    QVERIFY(open(router));
+
+    // 副本在运行中宕机：读在副本上失败后改到主库执行
+    StandInDriver::instances["replica"].down = true;
+    QCOMPARE(QString::fromStdString(run(router, "select * from doctor")), QString("primary"));
+    QCOMPARE(StandInDriver::instances["primary"].executed.size(), size_t(1));
+
+    // 主库上的失败不再重试
+    StandInDriver::instances["primary"].down = true;
+    QCOMPARE(QString::fromStdString(run(router, "insert into chat values('a')")), QString(""));
+    QCOMPARE(StandInDriver::instances["primary"].executed.size(), size_t(1));
+}
+
+void ServerRouterTest::testUnreachableReplicaSkipped()
+{
+    // 启动时连不上的副本不加入，读也走主库；主库连不上则启动失败
+    StandInDriver::instances["replica"].down = true;
+    StandInRouter router{ std::chrono::milliseconds(stickyMs) };
+    QVERIFY(open(router));
+    QCOMPARE(router.replica_count(), size_t(0));
+    QCOMPARE(QString::fromStdString(run(router, "select * from patient")), QString("primary"));
+
+    StandInDriver::instances["primary"].down = true;
+    StandInRouter unavailable{ std::chrono::milliseconds(stickyMs) };
+    QVERIFY(!open(unavailable));
+}
+
+QTEST_MAIN(ServerRouterTest)
+#include "ServerRouter_test.moc"
@@ -5,6 +5,7 @@
 #include <QTimer>
 #include <QThread>
 #include <QJsonDocument>
+#include <QTcpServer>
 #include "../../NetWork/tcpclient.h"
 #include "../mocks/MockTcpClient.h"
 #include "../config/test_config.h"
@@ -46,6 +47,17 @@ private slots:
     void testOnReadyReadWithInvalidJson();
     void testOnReadyReadWithReplyAndData();
 
+    // 带请求 id 的请求测试
+    void testRequestWithoutConnection();
+    void testRequestIdsAreUnique();
+    void testCancelRequest();
+    void testRequestContextDestroyed();
+
+    // 断线重连测试
+    void testReconnectReplaysQueuedRequest();
+    void testReconnectFailsWriteInFlight();
+    void testManualDisconnectDoesNotReconnect();
+
 private:
     TcpClient *m_tcpClient;
     MockTcpClient *m_mockClient;
@@ -486,5 +498,167 @@ void TcpClientTest::testOnReadyReadWithReplyAndData()
     qDebug() << "reply和data字段处理测试通过";
 }
 
+void TcpClientTest::testRequestWithoutConnection()
+{
+    qDebug() << "测试未连接时发送带 id 的请求";
+
+    m_tcpClient->disconnectFromServer();
+    QSignalSpy dataSpy(m_tcpClient, &TcpClient::dataReceivedJson);
+
+    QJsonObject reply;
+    int calls = 0;
+    m_tcpClient->request("ping", QJsonObject(), [&](const QJsonObject &r) {
+        reply = r;
+        ++calls;
+    });
+
+    // 不在 request 内部同步回调
+    QCOMPARE(calls, 0);
+    QTRY_COMPARE(calls, 1);
+    QCOMPARE(reply["reply"].toString(), QString("disconnected"));
+    QCOMPARE(m_tcpClient->pendingRequests(), 0);
+
+    // 回复只交给发请求的一方，不经过广播信号
+    QCOMPARE(dataSpy.count(), 0);
+
+    qDebug() << "未连接请求测试通过";
+}
+
+void TcpClientTest::testRequestIdsAreUnique()
+{
+    qDebug() << "测试请求 id 唯一";
+
+    quint64 first = m_tcpClient->request("ping", QJsonObject(), nullptr);
+    quint64 second = m_tcpClient->request("ping", QJsonObject(), nullptr);
+    QVERIFY(first != second);
+
+    m_tcpClient->cancel(first);
+    m_tcpClient->cancel(second);
+    QCOMPARE(m_tcpClient->pendingRequests(), 0);
+
+    qDebug() << "请求 id 唯一测试通过";
+}
+
+void TcpClientTest::testCancelRequest()
+{
+    qDebug() << "测试取消请求";
+
+    int calls = 0;
+    quint64 id = m_tcpClient->request("ping", QJsonObject(), [&](const QJsonObject &) { ++calls; }, nullptr, 50);
+    m_tcpClient->cancel(id);
+
+    // 取消之后既不会收到 disconnected，也不会收到 timeout
+    QTest::qWait(200);
+    QCOMPARE(calls, 0);
+
+    qDebug() << "取消请求测试通过";
+}
+
+void TcpClientTest::testRequestContextDestroyed()
+{
+    qDebug() << "测试接收方销毁后丢弃回复";
+
+    int calls = 0;
+    QObject *context = new QObject;
+    m_tcpClient->request("ping", QJsonObject(), [&](const QJsonObject &) { ++calls; }, context);
+    delete context;
+
+    QTRY_COMPARE(m_tcpClient->pendingRequests(), 0);
+    QCOMPARE(calls, 0);
+
+    qDebug() << "接收方销毁测试通过";
+}
+
+void TcpClientTest::testReconnectReplaysQueuedRequest()
+{
+    qDebug() << "测试断线重连后恢复会话并重发排队的请求";
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QSignalSpy reconnectedSpy(m_tcpClient, &TcpClient::reconnected);
+
+    m_tcpClient->setSessionToken("test-token");
+    m_tcpClient->connectToServer("127.0.0.1", server.serverPort());
+    QTRY_VERIFY_WITH_TIMEOUT(server.hasPendingConnections(), 2000);
+    QTest::qWait(100);
+
+    // 服务器一侧断开，客户端应立即开始重连
+    server.nextPendingConnection()->abort();
+    QTRY_VERIFY_WITH_TIMEOUT(server.hasPendingConnections(), 1000);
+    QTcpSocket *second = server.nextPendingConnection();
+
+    // 新连接上第一条是恢复会话的请求
+    QTRY_VERIFY_WITH_TIMEOUT(second->canReadLine(), 1000);
+    QJsonObject resume = QJsonDocument::fromJson(second->readLine()).object();
+    QCOMPARE(resume["command"].toString(), QString("resume"));
+    QCOMPARE(resume["data"].toObject()["token"].toString(), QString("test-token"));
+    QVERIFY(m_tcpClient->isReconnecting());
+
+    // 会话恢复前发出的请求先排队
+    QString reply;
+    m_tcpClient->request("queryCaseList", QJsonObject(), [&](const QJsonObject &r) { reply = r["reply"].toString(); });
+
+    second->write(QJsonDocument(QJsonObject{ { "reply", "successful" }, { "id", resume["id"] } })
+                      .toJson(QJsonDocument::Compact) + '\n');
+    QTRY_COMPARE_WITH_TIMEOUT(reconnectedSpy.count(), 1, 1000);
+
+    QTRY_VERIFY_WITH_TIMEOUT(second->canReadLine(), 1000);
+    QJsonObject request = QJsonDocument::fromJson(second->readLine()).object();
+    QCOMPARE(request["command"].toString(), QString("queryCaseList"));
+
+    // 回复仍交给原来的 handler
+    second->write(QJsonDocument(QJsonObject{ { "reply", "successful" }, { "id", request["id"] } })
+                      .toJson(QJsonDocument::Compact) + '\n');
+    QTRY_COMPARE(reply, QString("successful"));
+
+    m_tcpClient->setSessionToken(QString());
+    qDebug() << "断线重连重发测试通过";
+}
+
+void TcpClientTest::testReconnectFailsWriteInFlight()
+{
+    qDebug() << "测试断线时已发出的写请求不重发";
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QSignalSpy reconnectedSpy(m_tcpClient, &TcpClient::reconnected);
+
+    m_tcpClient->connectToServer("127.0.0.1", server.serverPort());
+    QTRY_VERIFY_WITH_TIMEOUT(server.hasPendingConnections(), 2000);
+    QTcpSocket *first = server.nextPendingConnection();
+    QTest::qWait(100);
+
+    QString reply;
+    m_tcpClient->request("modifyCase", QJsonObject(), [&](const QJsonObject &r) { reply = r["reply"].toString(); });
+    QTRY_VERIFY_WITH_TIMEOUT(first->canReadLine(), 1000);
+    first->abort();
+
+    QTRY_COMPARE_WITH_TIMEOUT(reconnectedSpy.count(), 1, 1000);
+    QCOMPARE(reply, QString("disconnected"));
+
+    qDebug() << "写请求不重发测试通过";
+}
+
+void TcpClientTest::testManualDisconnectDoesNotReconnect()
+{
+    qDebug() << "测试主动断开不重连";
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QSignalSpy reconnectingSpy(m_tcpClient, &TcpClient::reconnecting);
+
+    m_tcpClient->connectToServer("127.0.0.1", server.serverPort());
+    QTRY_VERIFY_WITH_TIMEOUT(server.hasPendingConnections(), 2000);
+    QTest::qWait(100);
+
+    m_tcpClient->disconnectFromServer();
+    QTest::qWait(500);
+
+    QCOMPARE(reconnectingSpy.count(), 0);
+    QVERIFY(!m_tcpClient->isReconnecting());
+
+    qDebug() << "主动断开测试通过";
+}
+
 QTEST_MAIN(TcpClientTest)
 #include "TcpClient_test.moc"
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <QCoreApplication>
 #include <QTemporaryDir>
 #include "../../Instance/UserSession.h"
+#include "../../Instance/SessionStore.h"
 #include "../config/test_config.h"
 
 class UserSessionTest : public QObject
@@ -32,6 +33,7 @@ private slots:
     void testSaveUserInfoToLocal();
     void testLoadUserInfoFromLocal();
     void testGetCacheFilePath();
+    void testCoalescedWrites();
 
     // 数据更新测试
     void testUpdateExistingUserInfo();
@@ -51,7 +53,7 @@ private:
     void createCacheDirectory();
     void cleanupCacheFiles();
     bool fileExists(const QString& filename);
-    QJsonObject loadJsonFromFile(const QString& filename);
+    QJsonObject loadCacheFile(const QString& filename);
 };
 
 void UserSessionTest::initTestCase()
@@ -147,8 +149,9 @@ void UserSessionTest::testSetUserInfo()
     QCOMPARE(m_session->getValue("phoneNumber"), QString("13800138000"));
     QCOMPARE(m_session->getValue("email"), QString("zhangsan@example.com"));
 
-    // 验证缓存文件是否被创建
+    // 验证缓存文件是否被创建（后台写入，先等待写完）
     QString expectedFile = m_session->getCacheFilePath(type, username);
+    SessionStore::instance().flush();
     QVERIFY(fileExists(expectedFile));
 
     qDebug() << "设置用户信息测试通过";
@@ -248,11 +251,12 @@ void UserSessionTest::testSaveUserInfoToLocal()
     // 获取缓存文件路径
     QString cacheFile = m_session->getCacheFilePath(type, username);
 
-    // 验证文件存在
+    // 验证文件存在（后台写入，先等待写完）
+    SessionStore::instance().flush();
     QVERIFY(fileExists(cacheFile));
 
     // 读取文件内容并验证
-    QJsonObject fileContent = loadJsonFromFile(cacheFile);
+    QJsonObject fileContent = loadCacheFile(cacheFile);
     QCOMPARE(fileContent.size(), userInfo.size());
 
     // 验证文件内容
@@ -307,25 +311,57 @@ void UserSessionTest::testGetCacheFilePath()
 
     // 测试不同用户类型的路径生成
     QString patientPath = m_session->getCacheFilePath("patient", "user123");
-    QString expectedPatientPath = "cache/patient_user123_local_user_info.json";
+    QString expectedPatientPath = "cache/patient_user123_local_user_info.cbor";
     QCOMPARE(patientPath, expectedPatientPath);
 
     QString doctorPath = m_session->getCacheFilePath("doctor", "doc456");
-    QString expectedDoctorPath = "cache/doctor_doc456_local_user_info.json";
+    QString expectedDoctorPath = "cache/doctor_doc456_local_user_info.cbor";
     QCOMPARE(doctorPath, expectedDoctorPath);
 
     QString adminPath = m_session->getCacheFilePath("admin", "admin789");
-    QString expectedAdminPath = "cache/admin_admin789_local_user_info.json";
+    QString expectedAdminPath = "cache/admin_admin789_local_user_info.cbor";
     QCOMPARE(adminPath, expectedAdminPath);
 
     // 测试特殊字符处理
     QString specialPath = m_session->getCacheFilePath("patient", "user-with.special@chars");
-    QString expectedSpecialPath = "cache/patient_user-with.special@chars_local_user_info.json";
+    QString expectedSpecialPath = "cache/patient_user-with.special@chars_local_user_info.cbor";
     QCOMPARE(specialPath, expectedSpecialPath);
 
     qDebug() << "获取缓存文件路径测试通过";
 }
 
+void UserSessionTest::testCoalescedWrites()
+{
+    qDebug() << "测试连续修改合并写入";
+
+    QString type = "patient";
+    QString username = "coalesceTest";
+
+    // 之前的测试留下的快照先写完，只统计本测试的写入
+    SessionStore::instance().flush();
+    const int writesBefore = SessionStore::instance().writeCount();
+
+    // 连续修改多次，只写一次文件，内容是最后一次的
+    for (int i = 0; i < 50; ++i) {
+        QJsonObject info;
+        info["phoneNumber"] = QString::number(13800000000LL + i);
+        m_session->setUserInfo(info, type, username);
+    }
+    QTest::qWait(SessionStore::coalesceMs * 2);  // 让合并的延时自然结束，不靠 flush 提前唤醒
+    SessionStore::instance().flush();
+    QCOMPARE(SessionStore::instance().writeCount() - writesBefore, 1);
+
+    QJsonObject fileContent = loadCacheFile(m_session->getCacheFilePath(type, username));
+    QCOMPARE(fileContent["phoneNumber"].toString(), QString("13800000049"));
+
+    // 原子替换不会留下临时文件
+    QDir cacheDir("cache");
+    QStringList leftovers = cacheDir.entryList(QStringList() << "*coalesceTest*", QDir::Files);
+    QCOMPARE(leftovers.size(), 1);
+
+    qDebug() << "合并写入测试通过";
+}
+
 void UserSessionTest::testUpdateExistingUserInfo()
 {
     qDebug() << "测试更新现有用户信息";
@@ -458,7 +494,7 @@ void UserSessionTest::cleanupCacheFiles()
 {
     QDir cacheDir("cache");
     if (cacheDir.exists()) {
-        QStringList files = cacheDir.entryList(QStringList() << "*_local_user_info.json", QDir::Files);
+        QStringList files = cacheDir.entryList(QStringList() << "*_local_user_info.json" << "*_local_user_info.cbor", QDir::Files);
         for (const QString& file : files) {
             cacheDir.remove(file);
         }
@@ -471,22 +507,18 @@ bool UserSessionTest::fileExists(const QString& filename)
     return file.exists();
 }
 
-QJsonObject UserSessionTest::loadJsonFromFile(const QString& filename)
+QJsonObject UserSessionTest::loadCacheFile(const QString& filename)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) {
+    QMap<QString, QString> info;
+    if (!SessionStore::load(filename, info)) {
         return QJsonObject();
     }
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    file.close();
-
-    if (doc.isObject()) {
-        return doc.object();
+    QJsonObject obj;
+    for (auto it = info.constBegin(); it != info.constEnd(); ++it) {
+        obj.insert(it.key(), it.value());
     }
-
-    return QJsonObject();
+    return obj;
 }
 
 QTEST_MAIN(UserSessionTest)